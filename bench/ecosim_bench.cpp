@@ -0,0 +1,483 @@
+// Benchmarks do motor de simulação, no estilo do Google Benchmark.
+//
+//   ./ecosim_bench [--filter=<texto>] [--min_time=<segundos>] [--json=<arquivo>]
+//
+// Microbenchmarks medem partes isoladas (kernels por espécie, sorteios,
+// consulta de vizinhos, serialização); os macrobenchmarks medem iterações por
+// segundo de mundos inteiros em vários tamanhos, densidades e números de
+// threads. Com --json o resultado sai no mesmo formato do Google Benchmark,
+// para comparar execuções e barrar regressões de desempenho.
+//
+// As alocações no heap também são contadas: os macrobenchmarks exigem que a
+// iteração em regime não aloque nada, e o programa termina com erro se
+// alguma alocar.
+
+#include "density.h"
+#include "placement.h"
+#include "plant_kernel.h"
+#include "rng.h"
+#include "serialize.h"
+#include "snapshot.h"
+#include "world.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::atomic<uint64_t> heap_allocations{0};
+
+    // Fora de linha para o compilador não casar o malloc/free daqui com os
+    // new/delete de quem chama (-Wmismatched-new-delete)
+    [[gnu::noinline]] void *countedAllocate(size_t size, size_t alignment = 0)
+    {
+        heap_allocations.fetch_add(1, std::memory_order_relaxed);
+        if (size == 0)
+            size = 1;
+        if (alignment <= alignof(std::max_align_t))
+            return std::malloc(size);
+        return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+
+    [[gnu::noinline]] void countedRelease(void *p) noexcept { std::free(p); }
+
+    void *checked(void *p)
+    {
+        if (!p)
+            throw std::bad_alloc();
+        return p;
+    }
+}
+
+// Todas as formas de new e delete do programa passam por aqui, para que as
+// alocações sejam contadas (inclusive as alinhadas e as sem exceção)
+void *operator new(size_t size) { return checked(countedAllocate(size)); }
+void *operator new[](size_t size) { return checked(countedAllocate(size)); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return countedAllocate(size); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return countedAllocate(size); }
+void *operator new(size_t size, std::align_val_t a) { return checked(countedAllocate(size, (size_t)a)); }
+void *operator new[](size_t size, std::align_val_t a) { return checked(countedAllocate(size, (size_t)a)); }
+void *operator new(size_t size, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+    return countedAllocate(size, (size_t)a);
+}
+void *operator new[](size_t size, std::align_val_t a, const std::nothrow_t &) noexcept
+{
+    return countedAllocate(size, (size_t)a);
+}
+
+void operator delete(void *p) noexcept { countedRelease(p); }
+void operator delete[](void *p) noexcept { countedRelease(p); }
+void operator delete(void *p, size_t) noexcept { countedRelease(p); }
+void operator delete[](void *p, size_t) noexcept { countedRelease(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { countedRelease(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { countedRelease(p); }
+void operator delete(void *p, std::align_val_t) noexcept { countedRelease(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { countedRelease(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { countedRelease(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { countedRelease(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { countedRelease(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { countedRelease(p); }
+
+namespace
+{
+    using bench_clock = std::chrono::steady_clock;
+
+    // Controla o laço de um benchmark: o tempo só conta a partir da primeira
+    // chamada a keepRunning(), então a preparação feita antes fica de fora
+    class bench_state_t
+    {
+    public:
+        explicit bench_state_t(double min_time) : min_time(min_time) {}
+
+        bool keepRunning()
+        {
+            bench_clock::time_point now = bench_clock::now();
+            if (!started)
+            {
+                started = true;
+                start = now;
+                return true;
+            }
+            iterations++;
+            return elapsed(now) < min_time;
+        }
+
+        // Exclui do tempo medido o trabalho entre pause() e resume()
+        void pause() { paused_at = bench_clock::now(); }
+        void resume() { start += bench_clock::now() - paused_at; }
+
+        double seconds() const { return elapsed(bench_clock::now()); }
+
+        uint64_t iterations = 0;
+        double items_per_iteration = 0; // ex.: células processadas por iteração
+        bool report_ticks = false;      // macrobenchmarks também reportam iterações da simulação por segundo
+        uint64_t allocations = 0;       // alocações no heap durante o laço medido
+        bool forbid_allocations = false; // o laço medido não pode alocar
+
+    private:
+        double elapsed(bench_clock::time_point now) const { return std::chrono::duration<double>(now - start).count(); }
+
+        double min_time;
+        bool started = false;
+        bench_clock::time_point start;
+        bench_clock::time_point paused_at;
+    };
+
+    // Impede o compilador de descartar um resultado não usado
+    template <typename T>
+    inline void doNotOptimize(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    struct benchmark_t
+    {
+        std::string name;
+        std::function<void(bench_state_t &)> run;
+    };
+
+    // Mundo quadrado com `density` das células ocupadas, divididas em 60% de
+    // plantas, 30% de herbívoros e 10% de carnívoros (ou só uma espécie)
+    void makeWorld(world_t &world, uint32_t size, double density, int only = -1)
+    {
+        world.reset(size, size, 42);
+        uint32_t filled = (uint32_t)(density * size * size);
+        if (only == plant)
+            placeEntities(world, filled, 0, 0);
+        else if (only == herbivore)
+            placeEntities(world, 0, filled, 0);
+        else if (only == carnivore)
+            placeEntities(world, 0, 0, filled);
+        else
+            placeEntities(world, filled * 6 / 10, filled * 3 / 10, filled / 10);
+    }
+
+    void benchCellRandom(bench_state_t &state)
+    {
+        const uint32_t draws = 1 << 20;
+        uint32_t key = streamKey(42, 0, STREAM_MOVE);
+        uint32_t sink = 0;
+        while (state.keepRunning())
+        {
+            for (uint32_t c = 0; c < draws; c++)
+                sink += drawProbability(cellRandom(key, c), probabilityThreshold(0.5));
+            key++;
+        }
+        doNotOptimize(sink);
+        state.items_per_iteration = draws;
+    }
+
+    void benchNeighbourScan(bench_state_t &state, uint32_t size)
+    {
+        world_t world;
+        makeWorld(world, size, 0.5);
+        const grid_t &grid = world.grid;
+        uint32_t sink = 0;
+        while (state.keepRunning())
+        {
+            for (uint32_t i = 0; i < grid.rows; i++)
+                for (uint32_t j = 0; j < grid.cols; j++)
+                    sink += grid.neighbours<von_neumann_t>(i, j, speciesSet(empty, plant));
+        }
+        doNotOptimize(sink);
+        state.items_per_iteration = (double)grid.size();
+    }
+
+    void benchPlantKernel(bench_state_t &state, uint32_t size)
+    {
+        world_t initial;
+        makeWorld(initial, size, 0.5, plant);
+        grid_t grid = initial.grid;
+        std::vector<uint8_t> seeded;
+        uint64_t tick = 0;
+        while (state.keepRunning())
+        {
+            state.pause();
+            grid = initial.grid; // sempre a mesma população inicial
+            state.resume();
+            simulatePlants(grid, seeded, initial.rules.plant, initial.seed, tick++);
+        }
+        state.items_per_iteration = (double)grid.size();
+    }
+
+    // Fase completa com uma única espécie animal na grade
+    void benchAnimalKernel(bench_state_t &state, uint32_t size, entity_type_t species)
+    {
+        world_t initial;
+        makeWorld(initial, size, 0.3, species);
+        world_t world = initial;
+        worker_pool_t serial(1);
+        while (state.keepRunning())
+        {
+            state.pause();
+            world.grid = initial.grid;
+            state.resume();
+            simulateTick(world, serial);
+        }
+        state.items_per_iteration = (double)initial.grid.population(species);
+    }
+
+    // Escrita em um buffer reutilizado: depois da primeira, nenhuma alocação
+    void benchJson(bench_state_t &state, uint32_t size)
+    {
+        world_t world;
+        makeWorld(world, size, 0.5);
+        std::string out;
+        writeGridJson(world.grid, out);
+        uint64_t allocations = heap_allocations.load();
+        while (state.keepRunning())
+        {
+            out.clear();
+            writeGridJson(world.grid, out);
+        }
+        state.allocations = heap_allocations.load() - allocations;
+        state.forbid_allocations = true;
+        state.items_per_iteration = (double)world.grid.size();
+    }
+
+    void benchCompactJson(bench_state_t &state, uint32_t size)
+    {
+        world_t world;
+        makeWorld(world, size, 0.5);
+        std::string out;
+        writeGridCompactJson(world.grid, out);
+        uint64_t allocations = heap_allocations.load();
+        while (state.keepRunning())
+        {
+            out.clear();
+            writeGridCompactJson(world.grid, out);
+        }
+        state.allocations = heap_allocations.load() - allocations;
+        state.forbid_allocations = true;
+        state.items_per_iteration = (double)world.grid.size();
+    }
+
+    void benchBinary(bench_state_t &state, uint32_t size)
+    {
+        world_t world;
+        makeWorld(world, size, 0.5);
+        std::string out;
+        while (state.keepRunning())
+        {
+            out.clear();
+            writeGridBinary(world.grid, out);
+        }
+        state.items_per_iteration = (double)world.grid.size();
+    }
+
+    // Posicionamento inicial de `fill` das células em uma grade vazia
+    void benchPlacement(bench_state_t &state, uint32_t size, double fill)
+    {
+        world_t world;
+        uint32_t filled = (uint32_t)(fill * size * size);
+        while (state.keepRunning())
+        {
+            state.pause();
+            world.reset(size, size, 42);
+            state.resume();
+            placeEntities(world, filled * 6 / 10, filled * 3 / 10, filled - filled * 6 / 10 - filled * 3 / 10);
+        }
+        state.items_per_iteration = filled;
+    }
+
+    // Inicialização por um mapa de densidade gerado por ruído
+    void benchDensityNoise(bench_state_t &state, uint32_t size, unsigned threads)
+    {
+        world_t world;
+        worker_pool_t pool(threads);
+        noise_density_t noise;
+        noise.density[0] = 0.3;
+        noise.density[1] = 0.05;
+        noise.density[2] = 0.01;
+        while (state.keepRunning())
+        {
+            state.pause();
+            world.reset(size, size, 42);
+            state.resume();
+            populateFromNoise(world, noise, pool);
+        }
+        state.items_per_iteration = (double)world.grid.size();
+    }
+
+    // Carga de um snapshot: mapeamento do arquivo e reconstrução dos mapas de
+    // ocupação (o arquivo é gravado uma vez, fora da medição)
+    void benchSnapshotLoad(bench_state_t &state, uint32_t size)
+    {
+        world_t world;
+        makeWorld(world, size, 0.5);
+        const std::string path = (std::filesystem::temp_directory_path() / "ecosim_bench.snapshot").string();
+        saveSnapshot(world, path);
+        while (state.keepRunning())
+            loadSnapshot(world, path);
+        std::filesystem::remove(path);
+        state.items_per_iteration = (double)world.grid.size();
+    }
+
+    // Iterações de mundos inteiros. As primeiras, fora da medição, levam os
+    // rascunhos (arenas e listas de movimentos) ao tamanho de regime; a partir
+    // daí uma iteração não pode alocar
+    void benchTick(bench_state_t &state, uint32_t size, double density, unsigned threads)
+    {
+        world_t world;
+        makeWorld(world, size, density);
+        worker_pool_t pool(threads);
+        for (int warmup = 0; warmup < 10; warmup++)
+            simulateTick(world, pool);
+        uint64_t allocations = heap_allocations.load();
+        while (state.keepRunning())
+            simulateTick(world, pool);
+        state.allocations = heap_allocations.load() - allocations;
+        state.forbid_allocations = true;
+        state.items_per_iteration = (double)world.grid.size();
+        state.report_ticks = true;
+    }
+
+    std::vector<benchmark_t> registerBenchmarks()
+    {
+        std::vector<benchmark_t> list;
+        list.push_back({"BM_CellRandom", benchCellRandom});
+        for (uint32_t size : {64u, 512u})
+        {
+            std::string s = std::to_string(size);
+            list.push_back({"BM_NeighbourScan/" + s, [size](bench_state_t &st) { benchNeighbourScan(st, size); }});
+            list.push_back({"BM_PlantKernel/" + s, [size](bench_state_t &st) { benchPlantKernel(st, size); }});
+            list.push_back({"BM_HerbivoreKernel/" + s, [size](bench_state_t &st) { benchAnimalKernel(st, size, herbivore); }});
+            list.push_back({"BM_CarnivoreKernel/" + s, [size](bench_state_t &st) { benchAnimalKernel(st, size, carnivore); }});
+            list.push_back({"BM_SerializeJson/" + s, [size](bench_state_t &st) { benchJson(st, size); }});
+            list.push_back({"BM_SerializeCompact/" + s, [size](bench_state_t &st) { benchCompactJson(st, size); }});
+            list.push_back({"BM_SerializeBinary/" + s, [size](bench_state_t &st) { benchBinary(st, size); }});
+        }
+        for (uint32_t size : {512u, 4096u})
+            for (double fill : {0.01, 0.5, 1.0})
+            {
+                char name[64];
+                std::snprintf(name, sizeof(name), "BM_Placement/%u/fill:%.2f", size, fill);
+                list.push_back({name, [=](bench_state_t &st) { benchPlacement(st, size, fill); }});
+            }
+        for (uint32_t size : {512u, 4096u})
+            list.push_back({"BM_DensityNoise/" + std::to_string(size), [size](bench_state_t &st) { benchDensityNoise(st, size, 0); }});
+        for (uint32_t size : {512u, 4096u})
+            list.push_back({"BM_SnapshotLoad/" + std::to_string(size), [size](bench_state_t &st) { benchSnapshotLoad(st, size); }});
+
+        // Potências de 2 até o número de núcleos, mais o próprio número de núcleos
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned> thread_counts;
+        for (unsigned t = 1; t < cores; t *= 2)
+            thread_counts.push_back(t);
+        thread_counts.push_back(cores);
+
+        for (uint32_t size : {64u, 512u, 4096u})
+            for (double density : {0.1, 0.5, 0.9})
+                for (unsigned threads : thread_counts)
+                {
+                    char name[96];
+                    std::snprintf(name, sizeof(name), "BM_Tick/%u/density:%.1f/threads:%u", size, density, threads);
+                    list.push_back({name, [=](bench_state_t &st) { benchTick(st, size, density, threads); }});
+                }
+        return list;
+    }
+
+    void usage(const char *argv0)
+    {
+        std::cerr << "Usage: " << argv0 << " [--filter=<substring>] [--min_time=<seconds>] [--json=<file>] [--list]" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string filter, json_path;
+    double min_time = 0.5;
+    bool list_only = false;
+    for (int a = 1; a < argc; a++)
+    {
+        std::string arg = argv[a];
+        if (arg.rfind("--filter=", 0) == 0)
+            filter = arg.substr(9);
+        else if (arg.rfind("--min_time=", 0) == 0)
+            min_time = std::atof(arg.c_str() + 11);
+        else if (arg.rfind("--json=", 0) == 0)
+            json_path = arg.substr(7);
+        else if (arg == "--list")
+            list_only = true;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    nlohmann::json results = nlohmann::json::array();
+    int status = 0;
+    std::printf("%-44s %14s %12s %16s\n", "Benchmark", "Time (ns)", "Iterations", "Items/s");
+    for (const benchmark_t &bench : registerBenchmarks())
+    {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos)
+            continue;
+        if (list_only)
+        {
+            std::printf("%s\n", bench.name.c_str());
+            continue;
+        }
+
+        bench_state_t state(min_time);
+        bench.run(state);
+        double seconds = state.seconds();
+        double ns_per_iteration = seconds * 1e9 / (double)std::max<uint64_t>(state.iterations, 1);
+        double items_per_second = state.items_per_iteration * (double)state.iterations / seconds;
+        std::printf("%-44s %14.0f %12llu %16.4g\n", bench.name.c_str(), ns_per_iteration,
+                    (unsigned long long)state.iterations, items_per_second);
+        std::fflush(stdout);
+
+        nlohmann::json entry = {{"name", bench.name},
+                                {"run_name", bench.name},
+                                {"run_type", "iteration"},
+                                {"iterations", state.iterations},
+                                {"real_time", ns_per_iteration},
+                                {"cpu_time", ns_per_iteration},
+                                {"time_unit", "ns"},
+                                {"items_per_second", items_per_second}};
+        if (state.report_ticks)
+            entry["ticks_per_second"] = (double)state.iterations / seconds;
+        if (state.forbid_allocations)
+            entry["allocations_per_iteration"] = (double)state.allocations / (double)std::max<uint64_t>(state.iterations, 1);
+        results.push_back(entry);
+
+        if (state.forbid_allocations && state.allocations > 0)
+        {
+            std::cerr << bench.name << ": " << state.allocations << " heap allocations in steady state" << std::endl;
+            status = 1;
+        }
+    }
+
+    if (!json_path.empty())
+    {
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        nlohmann::json report = {{"context", {{"date", date},
+                                              {"executable", argv[0]},
+                                              {"num_cpus", std::thread::hardware_concurrency()},
+                                              {"plant_kernel", plantKernelName()},
+                                              {"min_time", min_time}}},
+                                 {"benchmarks", results}};
+        std::ofstream out(json_path);
+        out << report.dump(2) << std::endl;
+        if (!out)
+        {
+            std::cerr << "cannot write " << json_path << std::endl;
+            return 1;
+        }
+    }
+    return status;
+}
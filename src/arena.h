@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Memória de rascunho de uma iteração: cada alocação só avança um ponteiro,
+// e reset() devolve tudo de uma vez no começo da iteração seguinte. Há uma
+// arena por thread do pool (ver world_t::arenas), então não há travas.
+//
+// Quando o bloco atual acaba, um bloco novo de pelo menos o dobro da
+// capacidade total é pedido ao sistema; reset() troca os blocos por um só do
+// tamanho total. Depois das primeiras iterações um bloco comporta a iteração
+// inteira e a arena não aloca mais nada.
+class arena_t
+{
+public:
+    arena_t() = default;
+
+    // O conteúdo é só rascunho: cópias começam vazias
+    arena_t(const arena_t &) {}
+    arena_t &operator=(const arena_t &) { return *this; }
+    arena_t(arena_t &&) noexcept = default;
+    arena_t &operator=(arena_t &&) noexcept = default;
+
+    // Memória não inicializada para n objetos; reset() não chama
+    // destrutores, então só serve para tipos triviais
+    template <typename T>
+    T *allocate(size_t n)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is released without destructors");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+        return static_cast<T *>(allocateBytes(n * sizeof(T), alignof(T)));
+    }
+
+    // Invalida tudo o que foi alocado desde o último reset()
+    void reset()
+    {
+        if (blocks.size() > 1)
+        {
+            blocks.clear();
+            addBlock(total);
+        }
+        used = 0;
+    }
+
+    // Bytes reservados do sistema
+    size_t capacity() const { return total; }
+
+private:
+    static constexpr size_t MIN_BLOCK = 64 * 1024;
+
+    struct block_t
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    void *allocateBytes(size_t bytes, size_t align)
+    {
+        size_t offset = (used + align - 1) & ~(align - 1);
+        if (blocks.empty() || offset + bytes > blocks.back().size)
+        {
+            addBlock(std::max({bytes, 2 * total, MIN_BLOCK}));
+            offset = 0; // new[] alinha para max_align_t
+        }
+        used = offset + bytes;
+        return blocks.back().data.get() + offset;
+    }
+
+    void addBlock(size_t size)
+    {
+        blocks.push_back({std::make_unique<std::byte[]>(size), size});
+        total = 0;
+        for (const block_t &block : blocks)
+            total += block.size;
+        used = 0;
+    }
+
+    std::vector<block_t> blocks;
+    size_t used = 0;  // bytes usados do último bloco
+    size_t total = 0; // soma dos tamanhos dos blocos
+};
+
+// Lista só de inserção com os elementos em pedaços alocados de uma arena.
+// Cada pedaço tem o dobro da capacidade do anterior, até um limite, então
+// listas curtas ocupam pouco e longas não fazem muitas alocações. Vale até o
+// próximo reset() da arena; clear() a esvazia sem tocar na memória antiga.
+template <typename T>
+class arena_list_t
+{
+public:
+    void clear()
+    {
+        head = nullptr;
+        tail = nullptr;
+    }
+
+    void push_back(arena_t &arena, const T &value)
+    {
+        if (!tail || tail->count == tail->capacity)
+        {
+            const uint32_t capacity = tail ? std::min(2 * tail->capacity, MAX_CHUNK_ITEMS) : MIN_CHUNK_ITEMS;
+            chunk_t *chunk = arena.allocate<chunk_t>(1);
+            chunk->next = nullptr;
+            chunk->items = arena.allocate<T>(capacity);
+            chunk->count = 0;
+            chunk->capacity = capacity;
+            (tail ? tail->next : head) = chunk;
+            tail = chunk;
+        }
+        tail->items[tail->count++] = value;
+    }
+
+    // Chama fn(elemento) na ordem de inserção
+    template <typename Fn>
+    void forEach(Fn &&fn) const
+    {
+        for (const chunk_t *chunk = head; chunk; chunk = chunk->next)
+            for (uint32_t k = 0; k < chunk->count; k++)
+                fn(chunk->items[k]);
+    }
+
+private:
+    static constexpr uint32_t MIN_CHUNK_ITEMS = 8;
+    static constexpr uint32_t MAX_CHUNK_ITEMS = 1024;
+
+    struct chunk_t
+    {
+        chunk_t *next;
+        T *items;
+        uint32_t count;
+        uint32_t capacity;
+    };
+
+    chunk_t *head = nullptr;
+    chunk_t *tail = nullptr;
+};
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "topology.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Mapa de ocupação com 1 bit por célula (64 células por palavra).
+// Cada linha começa em uma palavra nova e tem uma coluna de borda de cada
+// lado; há também uma linha de borda acima e abaixo da grade. Assim as
+// consultas aos vizinhos nunca precisam testar os limites.
+//
+// Com o contorno clip as bordas ficam vazias em todos os mapas, inclusive no
+// das células vazias: funcionam como paredes, onde nada entra. Com torus e
+// reflect elas são células fantasma que repetem a célula de dentro da grade
+// que fica além da borda (ghostSource()); set() e reset() as mantêm quando
+// alteram uma célula que elas repetem, e refreshGhosts() as recalcula depois
+// de escritas diretas nas palavras.
+struct bitboard_t
+{
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    uint32_t words_per_row = 0;
+    std::vector<uint64_t> words;
+
+    void assign(uint32_t num_rows, uint32_t num_cols, boundary_t boundary = BOUNDARY_CLIP)
+    {
+        rows = num_rows;
+        cols = num_cols;
+        words_per_row = (cols + 2 + 63) / 64;
+        // uma palavra a mais no fim para bitsAt() na última linha
+        words.assign((size_t)(rows + 2) * words_per_row + 1, 0);
+
+        ghosted = false;
+        for (int k = 0; k < 2; k++)
+        {
+            ghost_row_source[k] = ghostSource(boundary, k ? (int64_t)rows : -1, rows);
+            ghost_col_source[k] = ghostSource(boundary, k ? (int64_t)cols : -1, cols);
+            ghosted |= ghost_row_source[k] >= 0 || ghost_col_source[k] >= 0;
+        }
+
+        // Bits das colunas de dentro da grade em cada palavra de uma linha
+        interior.assign(words_per_row, ~0ULL);
+        interior[0] &= ~1ULL;
+        for (uint32_t w = 0; w < words_per_row; w++)
+        {
+            uint64_t first = (uint64_t)w * 64;
+            if (cols < first)
+                interior[w] = 0;
+            else if (cols < first + 63)
+                interior[w] &= ~0ULL >> (63 - (cols - first));
+        }
+    }
+
+    void clear() { words.assign(words.size(), 0); }
+
+    // Linha i da grade (i = -1 e i = rows são as linhas de borda)
+    uint64_t *row(int64_t i) { return words.data() + (size_t)(i + 1) * words_per_row; }
+    const uint64_t *row(int64_t i) const { return words.data() + (size_t)(i + 1) * words_per_row; }
+
+    // Máscara das células da grade (sem as bordas) na palavra w de uma linha
+    uint64_t interiorMask(uint32_t w) const { return interior[w]; }
+
+    // Bit da coluna j (j = -1 e j = cols são as colunas de borda)
+    bool test(int64_t i, int64_t j) const
+    {
+        uint64_t b = (uint64_t)(j + 1);
+        return (row(i)[b >> 6] >> (b & 63)) & 1;
+    }
+
+    // Bits das colunas j, j + 1, ... da linha i (j = -1 é a borda), a partir
+    // do bit 0; só os bits até a coluna de borda cols são da linha i
+    uint64_t bitsAt(int64_t i, int64_t j) const { return bitsAt(row(i), j); }
+
+    // O mesmo a partir de um ponteiro de row(), para laços que percorrem uma
+    // linha inteira
+    static uint64_t bitsAt(const uint64_t *r, int64_t j)
+    {
+        uint64_t b = (uint64_t)(j + 1);
+        const uint64_t *p = r + (b >> 6);
+        const uint32_t s = (uint32_t)(b & 63);
+        return (p[0] >> s) | (p[1] << 1 << (63 - s));
+    }
+
+    void set(uint32_t i, uint32_t j)
+    {
+        setBit(i, j);
+        if (ghosted)
+            updateGhosts(i, j, true);
+    }
+
+    void reset(uint32_t i, uint32_t j)
+    {
+        resetBit(i, j);
+        if (ghosted)
+            updateGhosts(i, j, false);
+    }
+
+    // Vizinhos de (i, j) da vizinhança N como máscara de bits, na ordem de
+    // N::at(i)
+    template <typename N>
+    uint32_t neighbours(uint32_t i, uint32_t j) const
+    {
+        const offset_t *o = N::at(i);
+        uint32_t mask = 0;
+        for (uint32_t d = 0; d < N::count; d++)
+            mask |= (uint32_t)test((int64_t)i + o[d].di, (int64_t)j + o[d].dj) << d;
+        return mask;
+    }
+
+    // Recalcula as células fantasma a partir da grade: primeiro as colunas
+    // de borda de cada linha, depois as linhas de borda inteiras (incluindo
+    // os cantos)
+    void refreshGhosts()
+    {
+        if (!ghosted)
+            return;
+        for (uint32_t i = 0; i < rows; i++)
+            for (int k = 0; k < 2; k++)
+                assignBit(i, k ? (int64_t)cols : -1, ghost_col_source[k] >= 0 && test(i, ghost_col_source[k]));
+        for (int k = 0; k < 2; k++)
+        {
+            uint64_t *ghost = row(k ? (int64_t)rows : -1);
+            if (ghost_row_source[k] >= 0)
+                std::copy(row(ghost_row_source[k]), row(ghost_row_source[k]) + words_per_row, ghost);
+            else
+                std::fill(ghost, ghost + words_per_row, 0);
+        }
+    }
+
+    size_t count() const
+    {
+        size_t total = 0;
+        for (uint32_t i = 0; i < rows; i++)
+        {
+            const uint64_t *r = row(i);
+            for (uint32_t w = 0; w < words_per_row; w++)
+                total += (size_t)__builtin_popcountll(r[w] & interior[w]);
+        }
+        return total;
+    }
+
+    // Chama fn(i, j) para cada bit ligado da linha i, pulando palavras vazias
+    // inteiras
+    template <typename Fn>
+    void forEachInRow(uint32_t i, Fn &&fn) const
+    {
+        const uint64_t *r = row(i);
+        for (uint32_t w = 0; w < words_per_row; w++)
+        {
+            uint64_t bits = r[w] & interior[w];
+            while (bits)
+            {
+                uint32_t b = (uint32_t)__builtin_ctzll(bits);
+                fn(i, w * 64 + b - 1);
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // O mesmo para a grade inteira, linha por linha
+    template <typename Fn>
+    void forEach(Fn &&fn) const
+    {
+        for (uint32_t i = 0; i < rows; i++)
+            forEachInRow(i, fn);
+    }
+
+private:
+    void setBit(int64_t i, int64_t j)
+    {
+        uint64_t b = (uint64_t)(j + 1);
+        row(i)[b >> 6] |= 1ULL << (b & 63);
+    }
+
+    void resetBit(int64_t i, int64_t j)
+    {
+        uint64_t b = (uint64_t)(j + 1);
+        row(i)[b >> 6] &= ~(1ULL << (b & 63));
+    }
+
+    void assignBit(int64_t i, int64_t j, bool value)
+    {
+        if (value)
+            setBit(i, j);
+        else
+            resetBit(i, j);
+    }
+
+    // Copia o bit de (i, j) para as células fantasma que o repetem (só as
+    // células perto das bordas têm alguma)
+    void updateGhosts(uint32_t i, uint32_t j, bool value)
+    {
+        int64_t ghost_rows[3] = {i}, ghost_cols[3] = {j};
+        int nr = 1, nc = 1;
+        for (int k = 0; k < 2; k++)
+        {
+            if (ghost_row_source[k] == i)
+                ghost_rows[nr++] = k ? (int64_t)rows : -1;
+            if (ghost_col_source[k] == j)
+                ghost_cols[nc++] = k ? (int64_t)cols : -1;
+        }
+        if (nr == 1 && nc == 1)
+            return;
+        for (int r = 0; r < nr; r++)
+            for (int c = 0; c < nc; c++)
+                if (r || c)
+                    assignBit(ghost_rows[r], ghost_cols[c], value);
+    }
+
+    bool ghosted = false;
+    int64_t ghost_row_source[2] = {-1, -1}; // linha repetida pelas bordas -1 e rows
+    int64_t ghost_col_source[2] = {-1, -1}; // coluna repetida pelas bordas -1 e cols
+    std::vector<uint64_t> interior;
+};
+
+// Escolhe o n-ésimo bit ligado (n < popcount) de uma máscara de vizinhos
+inline uint32_t nthDirection(uint32_t mask, uint32_t n)
+{
+    for (; n > 0; n--)
+        mask &= mask - 1;
+    return (uint32_t)__builtin_ctz(mask);
+}
+
+// Escolhe um dos vizinhos da máscara usando um número aleatório; o
+// resultado indexa os deslocamentos da vizinhança
+inline uint32_t randomDirection(uint32_t mask, uint32_t random)
+{
+    return nthDirection(mask, random % (uint32_t)__builtin_popcount(mask));
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Coluna contígua de um campo da grade. Normalmente os dados ficam em um
+// vetor próprio; adopt() passa a usar memória de outro dono, como um arquivo
+// mapeado com MAP_PRIVATE (ver snapshot.h), em que a primeira escrita em cada
+// página cria uma cópia privada. Cópias da coluna sempre copiam os dados para
+// um vetor próprio, então duas grades nunca compartilham células.
+template <typename T>
+class column_t
+{
+public:
+    column_t() = default;
+
+    column_t(const column_t &other) { copyFrom(other); }
+
+    column_t &operator=(const column_t &other)
+    {
+        if (this != &other)
+            copyFrom(other);
+        return *this;
+    }
+
+    column_t(column_t &&other) noexcept { moveFrom(other); }
+
+    column_t &operator=(column_t &&other) noexcept
+    {
+        if (this != &other)
+            moveFrom(other);
+        return *this;
+    }
+
+    void assign(size_t n, T value)
+    {
+        keepalive.reset();
+        owned.assign(n, value);
+        ptr = owned.data();
+        count = n;
+    }
+
+    // Usa `n` elementos em `data`, mantidos vivos por `owner`
+    void adopt(std::shared_ptr<void> owner, T *data, size_t n)
+    {
+        owned.clear();
+        owned.shrink_to_fit();
+        keepalive = std::move(owner);
+        ptr = data;
+        count = n;
+    }
+
+    T *data() { return ptr; }
+    const T *data() const { return ptr; }
+    size_t size() const { return count; }
+
+    T &operator[](size_t i) { return ptr[i]; }
+    const T &operator[](size_t i) const { return ptr[i]; }
+
+    T *begin() { return ptr; }
+    T *end() { return ptr + count; }
+    const T *begin() const { return ptr; }
+    const T *end() const { return ptr + count; }
+
+private:
+    void copyFrom(const column_t &other)
+    {
+        keepalive.reset();
+        owned.assign(other.begin(), other.end());
+        ptr = owned.data();
+        count = other.count;
+    }
+
+    void moveFrom(column_t &other)
+    {
+        owned = std::move(other.owned);
+        keepalive = std::move(other.keepalive);
+        ptr = keepalive ? other.ptr : owned.data();
+        count = other.count;
+        other.ptr = nullptr;
+        other.count = 0;
+    }
+
+    std::vector<T> owned;
+    std::shared_ptr<void> keepalive; // dono da memória adotada
+    T *ptr = nullptr;
+    size_t count = 0;
+};
@@ -0,0 +1,227 @@
+#include "density.h"
+#include "rng.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Linhas por tarefa da passada paralela; cada faixa só altera as próprias
+    // linhas da grade e dos mapas de ocupação
+    const uint32_t DENSITY_BAND_ROWS = 16;
+
+    const uint32_t MAX_NOISE_OCTAVES = 16;
+
+    // Valor pseudoaleatório em [0, 1] de um ponto da malha do ruído
+    double latticeValue(uint32_t key, int64_t x, int64_t y)
+    {
+        uint32_t h = mixRandom(((uint32_t)x * 0x9e3779b1U) ^ ((uint32_t)y * 0x85ebca77U) ^ key);
+        return (double)h / 4294967295.0;
+    }
+
+    double smooth(double t) { return t * t * (3 - 2 * t); }
+
+    // Soma em `out` (cols valores) uma camada de value noise da linha y, com
+    // frequência `frequency` e amplitude `amplitude`. Os valores da malha só
+    // são recalculados quando a coluna passa para a próxima célula da malha.
+    void addNoiseRow(uint32_t key, double y, double frequency, double amplitude, double *out, uint32_t cols)
+    {
+        double fy = std::floor(y);
+        int64_t iy = (int64_t)fy;
+        double ty = smooth(y - fy);
+        int64_t ix = INT64_MIN;
+        double top0 = 0, top1 = 0, bottom0 = 0, bottom1 = 0;
+        for (uint32_t j = 0; j < cols; j++)
+        {
+            double x = j * frequency;
+            double fx = std::floor(x);
+            if ((int64_t)fx != ix)
+            {
+                ix = (int64_t)fx;
+                top0 = latticeValue(key, ix, iy);
+                top1 = latticeValue(key, ix + 1, iy);
+                bottom0 = latticeValue(key, ix, iy + 1);
+                bottom1 = latticeValue(key, ix + 1, iy + 1);
+            }
+            double tx = smooth(x - fx);
+            double top = top0 + (top1 - top0) * tx;
+            double bottom = bottom0 + (bottom1 - bottom0) * tx;
+            out[j] += amplitude * (top + (bottom - top) * ty);
+        }
+    }
+
+    // Ruído fractal da linha i: soma de `octaves` camadas com o dobro da
+    // frequência e metade da amplitude da anterior, normalizada para [0, 1]
+    void fractalNoiseRow(uint32_t key, uint32_t i, const noise_density_t &noise, double *out, uint32_t cols)
+    {
+        std::fill(out, out + cols, 0.0);
+        double frequency = 1 / noise.scale, amplitude = 1, total = 0;
+        for (uint32_t o = 0; o < noise.octaves; o++)
+        {
+            addNoiseRow(key + o * 0x68e31da4U, i * frequency, frequency, amplitude, out, cols);
+            total += amplitude;
+            frequency *= 2;
+            amplitude *= 0.5;
+        }
+        for (uint32_t j = 0; j < cols; j++)
+            out[j] /= total;
+    }
+
+    // Passada paralela comum: fillRow(i, p) escreve em p[s][j] a
+    // probabilidade da espécie s em cada célula da linha i; se a soma passar
+    // de 1 elas são normalizadas
+    template <typename FillRow>
+    void populate(world_t &world, worker_pool_t &pool, FillRow &&fillRow)
+    {
+        grid_t &grid = world.grid;
+        const uint32_t key = streamKey(world.seed, world.tick, STREAM_DENSITY_PLACEMENT);
+        const entity_t entities[DENSITY_SPECIES_COUNT] = {{plant, 0, 0},
+                                                          {herbivore, world.rules.initial_energy, 0},
+                                                          {carnivore, world.rules.initial_energy, 0}};
+        const uint32_t bands = (grid.rows + DENSITY_BAND_ROWS - 1) / DENSITY_BAND_ROWS;
+        pool.parallelFor(bands, [&](size_t band) {
+            std::vector<double> buffers[DENSITY_SPECIES_COUNT];
+            double *p[DENSITY_SPECIES_COUNT];
+            for (size_t s = 0; s < DENSITY_SPECIES_COUNT; s++)
+            {
+                buffers[s].resize(grid.cols);
+                p[s] = buffers[s].data();
+            }
+            uint32_t first = (uint32_t)band * DENSITY_BAND_ROWS;
+            uint32_t last = std::min(first + DENSITY_BAND_ROWS, grid.rows);
+            for (uint32_t i = first; i < last; i++)
+            {
+                fillRow(i, p);
+                for (uint32_t j = 0; j < grid.cols; j++)
+                {
+                    double sum = p[0][j] + p[1][j] + p[2][j];
+                    double u = (double)cellRandom(key, (uint32_t)grid.index(i, j)) / 4294967296.0 * std::max(sum, 1.0);
+                    for (size_t s = 0; s < DENSITY_SPECIES_COUNT; s++)
+                    {
+                        if (u < p[s][j])
+                        {
+                            grid.at(i, j) = entities[s];
+                            break;
+                        }
+                        u -= p[s][j];
+                    }
+                }
+            }
+        });
+    }
+
+    double readProbability(const nlohmann::json &j, const char *key)
+    {
+        if (!j.contains(key))
+            return 0;
+        if (!j[key].is_number() || j[key].get<double>() < 0 || j[key].get<double>() > 1)
+            throw std::invalid_argument(std::string(key) + " must be a number between 0 and 1");
+        return j[key].get<double>();
+    }
+}
+
+density_raster_t parseDensityRaster(const std::string &data)
+{
+    uint32_t header[4];
+    if (data.size() < sizeof(header))
+        throw std::invalid_argument("density map is too short");
+    std::memcpy(header, data.data(), sizeof(header));
+    if (header[0] != DENSITY_RASTER_MAGIC)
+        throw std::invalid_argument("not a density map");
+    if (header[1] != DENSITY_RASTER_VERSION)
+        throw std::invalid_argument("unsupported density map version " + std::to_string(header[1]));
+
+    density_raster_t raster;
+    raster.rows = header[2];
+    raster.cols = header[3];
+    // rows * cols cabe em 64 bits; o limite vem antes de multiplicar pelo
+    // número de planos
+    const uint64_t plane = (uint64_t)raster.rows * raster.cols;
+    if (plane == 0 || plane > MAX_GRID_CELLS)
+        throw std::invalid_argument("density map must have between 1 and " + std::to_string(MAX_GRID_CELLS) + " cells");
+    if (data.size() - sizeof(header) != plane * DENSITY_SPECIES_COUNT)
+        throw std::invalid_argument("density map size does not match its header");
+    const char *p = data.data() + sizeof(header);
+    for (auto &values : raster.planes)
+    {
+        values.assign(p, p + plane);
+        p += plane;
+    }
+    return raster;
+}
+
+noise_density_t parseNoiseDensity(const nlohmann::json &j)
+{
+    if (!j.is_object())
+        throw std::invalid_argument("noise must be a JSON object");
+    for (auto it = j.begin(); it != j.end(); ++it)
+        if (it.key() != "scale" && it.key() != "octaves" && it.key() != "plants" && it.key() != "herbivores" &&
+            it.key() != "carnivores")
+            throw std::invalid_argument("unknown noise field " + it.key());
+
+    noise_density_t noise;
+    if (j.contains("scale"))
+    {
+        // manchas menores que uma célula não fazem sentido, e 1 / scale
+        // perto de zero estouraria as coordenadas da malha
+        if (!j["scale"].is_number() || !(j["scale"].get<double>() >= 1) ||
+            j["scale"].get<double>() > (double)MAX_GRID_CELLS)
+            throw std::invalid_argument("scale must be a number between 1 and " + std::to_string(MAX_GRID_CELLS));
+        noise.scale = j["scale"].get<double>();
+    }
+    if (j.contains("octaves"))
+    {
+        // comparado em 64 bits, antes de estreitar
+        if (!j["octaves"].is_number_unsigned() || j["octaves"].get<uint64_t>() == 0 ||
+            j["octaves"].get<uint64_t>() > MAX_NOISE_OCTAVES)
+            throw std::invalid_argument("octaves must be an integer between 1 and " + std::to_string(MAX_NOISE_OCTAVES));
+        noise.octaves = (uint32_t)j["octaves"].get<uint64_t>();
+    }
+    // A maior coordenada da malha é (linha ou coluna) * frequência da última
+    // camada; ela precisa caber em int64_t em addNoiseRow()
+    const double max_frequency = std::ldexp(1 / noise.scale, (int)noise.octaves - 1);
+    if (!std::isfinite(max_frequency) || max_frequency * (double)MAX_GRID_CELLS >= std::ldexp(1.0, 62))
+        throw std::invalid_argument("scale is too small for the number of octaves");
+    noise.density[0] = readProbability(j, "plants");
+    noise.density[1] = readProbability(j, "herbivores");
+    noise.density[2] = readProbability(j, "carnivores");
+    return noise;
+}
+
+void populateFromRaster(world_t &world, const density_raster_t &raster, worker_pool_t &pool)
+{
+    const grid_t &grid = world.grid;
+    populate(world, pool, [&](uint32_t i, double **p) {
+        uint64_t ri = (uint64_t)i * raster.rows / grid.rows;
+        for (size_t s = 0; s < DENSITY_SPECIES_COUNT; s++)
+        {
+            const uint8_t *row = raster.planes[s].data() + ri * raster.cols;
+            for (uint32_t j = 0; j < grid.cols; j++)
+                p[s][j] = row[(uint64_t)j * raster.cols / grid.cols] / 255.0;
+        }
+    });
+}
+
+void populateFromNoise(world_t &world, const noise_density_t &noise, worker_pool_t &pool)
+{
+    const uint32_t cols = world.grid.cols;
+    uint32_t keys[DENSITY_SPECIES_COUNT];
+    for (size_t s = 0; s < DENSITY_SPECIES_COUNT; s++)
+        keys[s] = streamKey(world.seed, s, STREAM_DENSITY_NOISE);
+    // O ruído tem média 0,5, então 2 * densidade * ruído tem a média pedida
+    // (exceto onde o produto passa de 1)
+    populate(world, pool, [&](uint32_t i, double **p) {
+        for (size_t s = 0; s < DENSITY_SPECIES_COUNT; s++)
+        {
+            if (noise.density[s] == 0)
+            {
+                std::fill(p[s], p[s] + cols, 0.0);
+                continue;
+            }
+            fractalNoiseRow(keys[s], i, noise, p[s], cols);
+            for (uint32_t j = 0; j < cols; j++)
+                p[s][j] = std::min(1.0, 2 * noise.density[s] * p[s][j]);
+        }
+    });
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "json.hpp"
+#include "world.h"
+#include "worker_pool.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Inicialização de mundos a partir de mapas de densidade: cada célula recebe
+// uma planta, um herbívoro ou um carnívoro com a probabilidade dada pelo
+// mapa de cada espécie naquela posição. Os sorteios usam o gerador baseado em
+// contador (rng.h), então o resultado depende só da semente do mundo, não do
+// número de threads.
+
+// Espécies de um mapa de densidade, na ordem dos planos
+const entity_type_t DENSITY_SPECIES[] = {plant, herbivore, carnivore};
+const size_t DENSITY_SPECIES_COUNT = 3;
+
+// Mapa enviado pelo cliente em formato binário: cabeçalho de 16 bytes (magic
+// "ECOD", versão, rows, cols, uint32 little-endian) seguido de um plano de
+// rows * cols bytes por espécie (plantas, herbívoros, carnívoros), cada byte
+// uma probabilidade v / 255. O mapa é esticado para o tamanho da grade.
+const uint32_t DENSITY_RASTER_MAGIC = 0x444f4345; // "ECOD"
+const uint32_t DENSITY_RASTER_VERSION = 1;
+
+struct density_raster_t
+{
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    std::vector<uint8_t> planes[DENSITY_SPECIES_COUNT];
+};
+
+// Lança std::invalid_argument se o conteúdo não for um mapa válido
+density_raster_t parseDensityRaster(const std::string &data);
+
+// Mapa gerado por ruído (value noise fractal): manchas de tamanho ~`scale`
+// células, com `octaves` camadas de detalhe. A densidade média de cada
+// espécie fica perto do valor pedido. Em JSON:
+//   {"scale": 32, "octaves": 4, "plants": 0.3, "herbivores": 0.05, "carnivores": 0.01}
+struct noise_density_t
+{
+    double scale = 32;
+    uint32_t octaves = 4;
+    double density[DENSITY_SPECIES_COUNT] = {0, 0, 0};
+};
+
+// Lança std::invalid_argument para campos desconhecidos ou valores inválidos
+noise_density_t parseNoiseDensity(const nlohmann::json &j);
+
+// Preenche a grade (já vazia, ver world_t::reset()) em uma passada paralela
+// por faixas de linhas
+void populateFromRaster(world_t &world, const density_raster_t &raster, worker_pool_t &pool);
+void populateFromNoise(world_t &world, const noise_density_t &noise, worker_pool_t &pool);
@@ -0,0 +1,87 @@
+#include "file_io.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+std::runtime_error ioError(const std::string &what, const std::string &path)
+{
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+file_t::~file_t()
+{
+    if (fd >= 0)
+        close(fd);
+}
+
+file_t &file_t::operator=(file_t &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (fd >= 0)
+            close(fd);
+        fd = other.fd;
+        other.fd = -1;
+    }
+    return *this;
+}
+
+void writeAll(int fd, iovec *iov, int count, const std::string &path)
+{
+    while (count > 0)
+    {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw ioError("cannot write", path);
+        }
+        while (count > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+void readAll(int fd, void *data, size_t size, const std::string &path)
+{
+    char *p = (char *)data;
+    while (size > 0)
+    {
+        ssize_t n = read(fd, p, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw ioError("cannot read", path);
+        if (n == 0)
+            throw std::runtime_error(path + ": unexpected end of file");
+        p += n;
+        size -= n;
+    }
+}
+
+void readAllAt(int fd, void *data, size_t size, uint64_t offset, const std::string &path)
+{
+    char *p = (char *)data;
+    while (size > 0)
+    {
+        ssize_t n = pread(fd, p, size, (off_t)offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw ioError("cannot read", path);
+        if (n == 0)
+            throw std::runtime_error(path + ": unexpected end of file");
+        p += n;
+        size -= n;
+        offset += n;
+    }
+}
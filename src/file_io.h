@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <sys/uio.h>
+
+// Rotinas de E/S de arquivos binários (snapshots, histórico). Todas lançam
+// std::runtime_error com o caminho e a mensagem do sistema.
+
+std::runtime_error ioError(const std::string &what, const std::string &path);
+
+// Fecha o descritor ao sair do escopo
+struct file_t
+{
+    int fd = -1;
+
+    file_t() = default;
+    explicit file_t(int fd) : fd(fd) {}
+    ~file_t();
+    file_t(const file_t &) = delete;
+    file_t &operator=(const file_t &) = delete;
+    file_t(file_t &&other) noexcept : fd(other.fd) { other.fd = -1; }
+    file_t &operator=(file_t &&other) noexcept;
+};
+
+// writev() pode escrever menos que o pedido (e no máximo ~2 GB por chamada
+// no Linux); repete até esvaziar todos os blocos. Altera `iov`.
+void writeAll(int fd, iovec *iov, int count, const std::string &path);
+
+// Lê exatamente `size` bytes a partir da posição atual ou de `offset`
+void readAll(int fd, void *data, size_t size, const std::string &path);
+void readAllAt(int fd, void *data, size_t size, uint64_t offset, const std::string &path);
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+#include "column.h"
+
+// Type definitions
+enum entity_type_t
+{
+    empty,
+    plant,
+    herbivore,
+    carnivore,
+    morta,
+    ENTITY_TYPE_COUNT
+};
+
+// Conjunto de espécies como máscara de bits, ex.: speciesSet(empty, plant)
+constexpr uint32_t speciesSet(entity_type_t t) { return 1u << t; }
+template <typename... Ts>
+constexpr uint32_t speciesSet(entity_type_t t, Ts... rest) { return (1u << t) | speciesSet(rest...); }
+
+// Maior grade (rows * cols) que os clientes podem pedir, pelo HTTP ou em
+// varreduras
+const uint64_t MAX_GRID_CELLS = 1ull << 28;
+
+struct grid_t;
+
+struct pos_t
+{
+    uint32_t i;
+    uint32_t j;
+};
+
+struct entity_t
+{
+    entity_type_t type;
+    int32_t energy;
+    int32_t age;
+};
+
+// Referência para o tipo de uma célula: a escrita passa pela grade para
+// manter os mapas de ocupação atualizados
+struct type_ref_t
+{
+    grid_t &grid;
+    uint32_t i;
+    uint32_t j;
+
+    operator entity_type_t() const;
+    type_ref_t &operator=(entity_type_t t);
+};
+
+// Referência para uma célula da grade, permite ler e escrever os três campos
+// como se fosse um entity_t
+struct cell_ref_t
+{
+    type_ref_t type;
+    int32_t &energy;
+    int32_t &age;
+
+    cell_ref_t &operator=(const entity_t &e)
+    {
+        type = e.type;
+        energy = e.energy;
+        age = e.age;
+        return *this;
+    }
+
+    operator entity_t() const { return {(entity_type_t)type, energy, age}; }
+};
+
+// Grade armazenada como estrutura de arrays (uma coluna contígua por campo),
+// para que os kernels consigam processar linhas inteiras de uma vez.
+// `occupancy` guarda um mapa de bits por tipo de entidade (incluindo as
+// células vazias), mantido junto com `type` por setType(). `changed` marca
+// as células cujo tipo mudou desde que alguém o limpou (ver mipmap.h); como
+// cada linha tem as próprias palavras, tarefas que alteram linhas distintas
+// podem marcá-lo sem travas. `topology` define os vizinhos de cada célula;
+// as bordas dos mapas de ocupação seguem o contorno dela.
+struct grid_t
+{
+    uint32_t rows = 0;
+    uint32_t cols = 0;
+    topology_t topology;
+    column_t<uint8_t> type;
+    column_t<int32_t> energy;
+    column_t<int32_t> age;
+    bitboard_t occupancy[ENTITY_TYPE_COUNT];
+    bitboard_t changed;
+
+    void assign(uint32_t num_rows, uint32_t num_cols, topology_t grid_topology = {})
+    {
+        rows = num_rows;
+        cols = num_cols;
+        topology = grid_topology;
+        type.assign((size_t)rows * cols, empty);
+        energy.assign((size_t)rows * cols, 0);
+        age.assign((size_t)rows * cols, 0);
+        for (bitboard_t &b : occupancy)
+            b.assign(rows, cols, topology.boundary);
+        changed.assign(rows, cols);
+        rebuildOccupancy();
+    }
+
+    // Passa a usar colunas já preenchidas (ex.: mapeadas de um snapshot), com
+    // rows * cols elementos e tipos válidos
+    void adopt(uint32_t num_rows, uint32_t num_cols, column_t<uint8_t> &&types, column_t<int32_t> &&energies,
+               column_t<int32_t> &&ages, topology_t grid_topology = {})
+    {
+        rows = num_rows;
+        cols = num_cols;
+        topology = grid_topology;
+        type = std::move(types);
+        energy = std::move(energies);
+        age = std::move(ages);
+        for (bitboard_t &b : occupancy)
+            b.assign(rows, cols, topology.boundary);
+        changed.assign(rows, cols);
+        rebuildOccupancy();
+    }
+
+    size_t size() const { return (size_t)rows * cols; }
+    size_t index(uint32_t i, uint32_t j) const { return (size_t)i * cols + j; }
+
+    cell_ref_t at(uint32_t i, uint32_t j)
+    {
+        size_t idx = index(i, j);
+        return {{*this, i, j}, energy[idx], age[idx]};
+    }
+
+    void setType(uint32_t i, uint32_t j, entity_type_t t)
+    {
+        uint8_t &current = type[index(i, j)];
+        occupancy[current].reset(i, j);
+        occupancy[t].set(i, j);
+        changed.set(i, j);
+        current = (uint8_t)t;
+    }
+
+    // Vizinhos de (i, j) na vizinhança N ocupados por alguma das espécies do
+    // conjunto, como máscara indexada pelos deslocamentos de N::at(i)
+    template <typename N>
+    uint32_t neighbours(uint32_t i, uint32_t j, uint32_t species) const
+    {
+        uint32_t mask = 0;
+        for (uint32_t t = 0; t < ENTITY_TYPE_COUNT; t++)
+            if (species & (1u << t))
+                mask |= occupancy[t].template neighbours<N>(i, j);
+        return mask;
+    }
+
+    // Posição do vizinho d de (i, j) na vizinhança N, levada para dentro da
+    // grade pelo contorno B; d precisa ser um vizinho existente
+    template <typename N, typename B>
+    pos_t neighbourPos(uint32_t i, uint32_t j, uint32_t d) const
+    {
+        const offset_t o = N::at(i)[d];
+        return {(uint32_t)B::wrap((int64_t)i + o.di, rows), (uint32_t)B::wrap((int64_t)j + o.dj, cols)};
+    }
+
+    size_t population(entity_type_t t) const { return occupancy[t].count(); }
+
+    // Recalcula os mapas de ocupação a partir de `type`; usado depois de
+    // kernels que alteram linhas inteiras de uma vez. Monta cada palavra dos
+    // mapas em registradores, marca em `changed` os bits que mudaram e por
+    // fim recalcula as células fantasma das bordas.
+    void rebuildOccupancy()
+    {
+        for (uint32_t i = 0; i < rows; i++)
+        {
+            const uint8_t *r = type.data() + index(i, 0);
+            const uint32_t words = changed.words_per_row;
+            for (uint32_t w = 0; w < words; w++)
+            {
+                // A palavra w cobre as colunas 64w - 1 .. 64w + 62 (bit 0 da
+                // primeira palavra é a borda)
+                uint64_t bits[ENTITY_TYPE_COUNT] = {};
+                int64_t first = std::max<int64_t>((int64_t)w * 64 - 1, 0);
+                int64_t last = std::min<int64_t>((int64_t)w * 64 + 63, cols);
+                for (int64_t j = first; j < last; j++)
+                    bits[r[j]] |= 1ULL << ((j + 1) & 63);
+                uint64_t diff = 0;
+                for (uint32_t t = 0; t < ENTITY_TYPE_COUNT; t++)
+                {
+                    uint64_t &word = occupancy[t].row(i)[w];
+                    diff |= word ^ bits[t];
+                    word = bits[t];
+                }
+                changed.row(i)[w] |= diff & changed.interiorMask(w);
+            }
+        }
+        for (bitboard_t &b : occupancy)
+            b.refreshGhosts();
+    }
+
+    entity_t get(uint32_t i, uint32_t j) const
+    {
+        size_t idx = index(i, j);
+        return {(entity_type_t)type[idx], energy[idx], age[idx]};
+    }
+};
+
+inline type_ref_t::operator entity_type_t() const
+{
+    return (entity_type_t)grid.type[grid.index(i, j)];
+}
+
+inline type_ref_t &type_ref_t::operator=(entity_type_t t)
+{
+    grid.setType(i, j, t);
+    return *this;
+}
@@ -0,0 +1,191 @@
+#include "history.h"
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace
+{
+    void putVarint(std::vector<uint8_t> &out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+
+    uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+    int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+    // Leitor de um quadro descomprimido; lança se os dados acabarem no meio
+    struct frame_reader_t
+    {
+        const uint8_t *p;
+        const uint8_t *end;
+        const std::string &path;
+
+        bool done() const { return p == end; }
+
+        uint8_t byte()
+        {
+            if (p == end)
+                throw std::runtime_error(path + ": corrupt history frame");
+            return *p++;
+        }
+
+        uint64_t varint()
+        {
+            uint64_t v = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                uint8_t b = byte();
+                v |= (uint64_t)(b & 0x7f) << shift;
+                if (!(b & 0x80))
+                    return v;
+            }
+            throw std::runtime_error(path + ": corrupt history frame");
+        }
+    };
+
+    template <typename T>
+    void appendColumn(std::vector<uint8_t> &out, const T *data, size_t count)
+    {
+        const uint8_t *bytes = (const uint8_t *)data;
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+    }
+}
+
+history_log_t::history_log_t(const std::string &path, const world_t &world, uint32_t keyframe_interval)
+    : file_path(path)
+{
+    if (keyframe_interval == 0)
+        throw std::invalid_argument("keyframe interval must be positive");
+    file = file_t(open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644));
+    if (file.fd < 0)
+        throw ioError("cannot create", path);
+
+    const grid_t &grid = world.grid;
+    header = {HISTORY_MAGIC, HISTORY_VERSION, grid.rows, grid.cols, world.seed, keyframe_interval, 0};
+    iovec iov[1] = {{&header, sizeof(header)}};
+    writeAll(file.fd, iov, 1, path);
+    file_size = sizeof(header);
+
+    last_type.assign(grid.type.begin(), grid.type.end());
+    last_energy.assign(grid.energy.begin(), grid.energy.end());
+    last_age.assign(grid.age.begin(), grid.age.end());
+    raw.clear();
+    appendColumn(raw, last_type.data(), last_type.size());
+    appendColumn(raw, last_energy.data(), last_energy.size());
+    appendColumn(raw, last_age.data(), last_age.size());
+    writeFrame(HISTORY_KEYFRAME, world.tick);
+}
+
+void history_log_t::writeFrame(history_frame_kind_t kind, uint64_t tick)
+{
+    uLongf compressed_size = compressBound(raw.size());
+    compressed.resize(compressed_size);
+    if (compress2(compressed.data(), &compressed_size, raw.data(), raw.size(), Z_BEST_SPEED) != Z_OK)
+        throw std::runtime_error(file_path + ": cannot compress history frame");
+
+    history_frame_t frame = {kind, 0, tick, raw.size(), compressed_size};
+    iovec iov[2] = {{&frame, sizeof(frame)}, {compressed.data(), compressed_size}};
+    writeAll(file.fd, iov, 2, file_path);
+    frames.push_back({tick, file_size, kind});
+    file_size += sizeof(frame) + compressed_size;
+}
+
+void history_log_t::append(const world_t &world)
+{
+    const grid_t &grid = world.grid;
+    if (grid.rows != header.rows || grid.cols != header.cols || world.tick != lastTick() + 1)
+        throw std::invalid_argument(file_path + ": world does not continue the recorded history");
+
+    const size_t cells = grid.size();
+    raw.clear();
+    if (world.tick % header.keyframe_interval == 0)
+    {
+        std::memcpy(last_type.data(), grid.type.data(), cells);
+        std::memcpy(last_energy.data(), grid.energy.data(), cells * sizeof(int32_t));
+        std::memcpy(last_age.data(), grid.age.data(), cells * sizeof(int32_t));
+        appendColumn(raw, last_type.data(), cells);
+        appendColumn(raw, last_energy.data(), cells);
+        appendColumn(raw, last_age.data(), cells);
+        writeFrame(HISTORY_KEYFRAME, world.tick);
+        return;
+    }
+
+    // Compara com a última grade gravada e já a atualiza na mesma passada
+    size_t next = 0; // célula seguinte à última alterada
+    for (size_t c = 0; c < cells; c++)
+    {
+        if (grid.type[c] == last_type[c] && grid.energy[c] == last_energy[c] && grid.age[c] == last_age[c])
+            continue;
+        putVarint(raw, c - next);
+        raw.push_back(grid.type[c]);
+        putVarint(raw, zigzag(grid.energy[c]));
+        putVarint(raw, zigzag(grid.age[c]));
+        last_type[c] = grid.type[c];
+        last_energy[c] = grid.energy[c];
+        last_age[c] = grid.age[c];
+        next = c + 1;
+    }
+    writeFrame(HISTORY_DELTA, world.tick);
+}
+
+void history_log_t::replay(uint64_t tick, grid_t &grid) const
+{
+    if (tick < firstTick() || tick > lastTick())
+        throw std::out_of_range("tick " + std::to_string(tick) + " is not in the history (" +
+                                std::to_string(firstTick()) + ".." + std::to_string(lastTick()) + ")");
+
+    // Os quadros têm iterações consecutivas, então o de `tick` está nesta posição
+    size_t target = (size_t)(tick - firstTick());
+    size_t k = target;
+    while (frames[k].kind != HISTORY_KEYFRAME)
+        k--;
+
+    const size_t cells = (size_t)header.rows * header.cols;
+    grid.assign(header.rows, header.cols);
+    std::vector<uint8_t> packed, unpacked;
+    for (; k <= target; k++)
+    {
+        history_frame_t frame;
+        readAllAt(file.fd, &frame, sizeof(frame), frames[k].offset, file_path);
+        packed.resize(frame.compressed_size);
+        readAllAt(file.fd, packed.data(), packed.size(), frames[k].offset + sizeof(frame), file_path);
+        unpacked.resize(frame.raw_size);
+        uLongf raw_size = frame.raw_size;
+        if (uncompress(unpacked.data(), &raw_size, packed.data(), packed.size()) != Z_OK || raw_size != frame.raw_size)
+            throw std::runtime_error(file_path + ": corrupt history frame");
+
+        if (frame.kind == HISTORY_KEYFRAME)
+        {
+            if (frame.raw_size != cells * (1 + 2 * sizeof(int32_t)))
+                throw std::runtime_error(file_path + ": corrupt history frame");
+            std::memcpy(grid.type.data(), unpacked.data(), cells);
+            std::memcpy(grid.energy.data(), unpacked.data() + cells, cells * sizeof(int32_t));
+            std::memcpy(grid.age.data(), unpacked.data() + cells * (1 + sizeof(int32_t)), cells * sizeof(int32_t));
+            continue;
+        }
+
+        frame_reader_t in{unpacked.data(), unpacked.data() + unpacked.size(), file_path};
+        size_t next = 0;
+        while (!in.done())
+        {
+            uint64_t c = next + in.varint();
+            if (c >= cells)
+                throw std::runtime_error(file_path + ": corrupt history frame");
+            grid.type[c] = in.byte();
+            grid.energy[c] = unzigzag((uint32_t)in.varint());
+            grid.age[c] = unzigzag((uint32_t)in.varint());
+            next = c + 1;
+        }
+    }
+
+    for (uint8_t t : grid.type)
+        if (t >= ENTITY_TYPE_COUNT)
+            throw std::runtime_error(file_path + ": invalid entity type in history");
+    grid.rebuildOccupancy();
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "file_io.h"
+#include "grid.h"
+#include "world.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Histórico de uma simulação gravado em disco, iteração a iteração, para
+// rever qualquer estado passado sem simular de novo.
+//
+// Formato (little-endian): history_header_t seguido de quadros, cada um com
+// um history_frame_t e o conteúdo comprimido com zlib. O primeiro quadro e um
+// a cada `keyframe_interval` iterações são quadros-chave, com a grade
+// inteira (colunas type, energy e age); os demais só trazem as células que
+// mudaram desde a iteração anterior, cada uma como
+//   varint(distância desde a célula alterada anterior) type
+//   varint_zigzag(energy) varint_zigzag(age)
+// Para chegar à iteração N basta ler o quadro-chave anterior mais próximo e
+// aplicar os quadros seguintes até N.
+const uint32_t HISTORY_MAGIC = 0x484f4345; // "ECOH"
+const uint32_t HISTORY_VERSION = 1;
+const uint32_t DEFAULT_KEYFRAME_INTERVAL = 100;
+
+struct history_header_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t rows;
+    uint32_t cols;
+    uint64_t seed;
+    uint32_t keyframe_interval;
+    uint32_t reserved;
+};
+static_assert(sizeof(history_header_t) == 32, "history header must be packed");
+
+enum history_frame_kind_t : uint32_t
+{
+    HISTORY_KEYFRAME = 1,
+    HISTORY_DELTA = 2
+};
+
+struct history_frame_t
+{
+    uint32_t kind; // history_frame_kind_t
+    uint32_t reserved;
+    uint64_t tick;            // estado ao fim desta iteração
+    uint64_t raw_size;        // tamanho antes da compressão
+    uint64_t compressed_size; // bytes que seguem este cabeçalho
+};
+static_assert(sizeof(history_frame_t) == 32, "history frame header must be packed");
+
+// Arquivo de histórico em gravação. Os métodos lançam std::runtime_error em
+// erros de E/S ou dados corrompidos.
+class history_log_t
+{
+public:
+    // Cria `path`, que não pode existir (um histórico gravado nunca é
+    // sobrescrito), e grava o estado atual de `world` como o primeiro
+    // quadro-chave
+    history_log_t(const std::string &path, const world_t &world, uint32_t keyframe_interval);
+
+    // Grava o estado de `world`, que deve estar na iteração seguinte à
+    // última gravada (std::invalid_argument caso contrário)
+    void append(const world_t &world);
+
+    uint64_t firstTick() const { return frames.front().tick; }
+    uint64_t lastTick() const { return frames.back().tick; }
+    uint64_t bytes() const { return file_size; }
+    const std::string &path() const { return file_path; }
+
+    // Reconstrói em `grid` o estado ao fim da iteração `tick`; lança
+    // std::out_of_range se ela não estiver no histórico
+    void replay(uint64_t tick, grid_t &grid) const;
+
+private:
+    struct frame_ref_t
+    {
+        uint64_t tick;
+        uint64_t offset; // posição do history_frame_t no arquivo
+        uint32_t kind;
+    };
+
+    void writeFrame(history_frame_kind_t kind, uint64_t tick);
+
+    std::string file_path;
+    file_t file;
+    history_header_t header;
+    std::vector<frame_ref_t> frames;
+    uint64_t file_size = 0;
+
+    // Última grade gravada, para calcular as diferenças, e rascunhos
+    std::vector<uint8_t> last_type;
+    std::vector<int32_t> last_energy;
+    std::vector<int32_t> last_age;
+    std::vector<uint8_t> raw;
+    std::vector<uint8_t> compressed;
+};
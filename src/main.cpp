@@ -3,472 +3,328 @@
 
 #include "crow_all.h"
 #include "json.hpp"
+#include "density.h"
+#include "grid.h"
+#include "history.h"
+#include "metrics.h"
+#include "params.h"
+#include "placement.h"
+#include "serialize.h"
+#include "series.h"
+#include "snapshot.h"
+#include "plant_kernel.h"
+#include "species.h"
+#include "stats.h"
+#include "sweep.h"
+#include "trace.h"
+#include "world.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
 #include <random>
 #include <cstdlib>
 #include <ctime>
+#include <fstream>
+#include <map>
+#include <memory>
 #include <mutex>
-#include <condition_variable>
+#include <sstream>
+#include <sys/stat.h>
 
 static const uint32_t NUM_ROWS = 15;
-
-std::mutex grid;
-std::condition_variable cv_thread;
-std::condition_variable cv_grid;
-std::mutex mtx_cv;
-std::mutex mtx_wait_end;
-std::mutex mtx_counter;
-std::mutex mtx_total;
-std::mutex mtx_cout;
-int total_entidades;
-int *iteracao_terminada = new int(0);
-int *thread_criada = new int(0);
-
-// Constants
-const uint32_t PLANT_MAXIMUM_AGE = 10;
-const uint32_t HERBIVORE_MAXIMUM_AGE = 50;
-const uint32_t CARNIVORE_MAXIMUM_AGE = 80;
-const uint32_t MAXIMUM_ENERGY = 200;
-const uint32_t THRESHOLD_ENERGY_FOR_REPRODUCTION = 20;
-
-// Probabilities
-const double PLANT_REPRODUCTION_PROBABILITY = 0.2;
-const double HERBIVORE_REPRODUCTION_PROBABILITY = 0.075;
-const double CARNIVORE_REPRODUCTION_PROBABILITY = 0.025;
-const double HERBIVORE_MOVE_PROBABILITY = 0.7;
-const double HERBIVORE_EAT_PROBABILITY = 0.9;
-const double CARNIVORE_MOVE_PROBABILITY = 0.5;
-const double CARNIVORE_EAT_PROBABILITY = 1.0;
-
-// Type definitions
-enum entity_type_t
-{
-    empty,
-    plant,
-    herbivore,
-    carnivore,
-    morta
-};
-
-struct pos_t
+static const unsigned HTTP_MIN_THREADS = 4;
+static const double MAX_TRACE_SECONDS = 60;
+static const unsigned MAX_SWEEP_THREADS = 1024; // --threads
+static const uint64_t MAX_VIEW_BLOCKS = 1ull << 20; // blocos (ou células) devolvidos por /view
+
+// Simulation state: the grid that contains the entities plus the engine state.
+// mtx_world serializes the HTTP handlers that read or advance it.
+static world_t world;
+static grid_t &entity_grid = world.grid;
+profiled_mutex_t mtx_world{"world"};
+
+// Durações das fases e taxa de iterações, expostas em /metrics
+static engine_metrics_t engine_metrics;
+
+// Parâmetros usados por /start-simulation quando o corpo não traz os seus
+// (os padrão de species.h ou os lidos de --params <arquivo>)
+static rule_params_t default_params;
+
+// Diretório onde /checkpoint grava e /restore procura os snapshots
+// (--checkpoint-dir); os nomes vindos do cliente não podem conter '/'
+static std::string checkpoint_dir = ".";
+static const char *const DEFAULT_SNAPSHOT_NAME = "ecosim.snapshot";
+
+// Caminho do snapshot pedido em ?name=; vazio se o nome for inválido
+std::string snapshotPath(const crow::request &req)
 {
-    uint32_t i;
-    uint32_t j;
-};
+    std::string name = req.url_params.get("name") ? req.url_params.get("name") : DEFAULT_SNAPSHOT_NAME;
+    if (name.empty() || name[0] == '.' || name.size() > 255)
+        return "";
+    for (char c : name)
+        if (!std::isalnum((unsigned char)c) && c != '.' && c != '_' && c != '-')
+            return "";
+    return checkpoint_dir + "/" + name;
+}
 
-struct entity_t
+// Lê um inteiro não negativo em decimal; false se o texto não for só um
+// número ou não couber em 64 bits
+bool parseUnsigned(const char *v, uint64_t &out)
 {
-    entity_type_t type;
-    int32_t energy;
-    int32_t age;
-};
+    char *end = nullptr;
+    errno = 0;
+    out = std::strtoull(v, &end, 10);
+    return std::isdigit((unsigned char)*v) && *end == '\0' && errno != ERANGE;
+}
 
-// Auxiliary code to convert the entity_type_t enum to a string
-NLOHMANN_JSON_SERIALIZE_ENUM(entity_type_t, {
-                                                {empty, " "},
-                                                {plant, "P"},
-                                                {herbivore, "H"},
-                                                {carnivore, "C"},
-                                                {morta, "M"},
-                                            })
-
-// Auxiliary code to convert the entity_t struct to a JSON object
-namespace nlohmann
+// Lê um inteiro não negativo da query string; `fallback` se ausente, false
+// se o valor não for um número ou não couber em 64 bits
+bool queryUnsigned(const crow::request &req, const char *key, uint64_t fallback, uint64_t &out)
 {
-    void to_json(nlohmann::json &j, const entity_t &e)
-    {
-        j = nlohmann::json{{"type", e.type}, {"energy", e.energy}, {"age", e.age}};
+    const char *v = req.url_params.get(key);
+    if (!v) {
+        out = fallback;
+        return true;
     }
+    return parseUnsigned(v, out);
 }
 
-// Grid that contains the entities
-static std::vector<std::vector<entity_t>> entity_grid;
-std::vector<std::thread> thread_vec;
-
-bool getProbability(double prob)
+// Mesmo que queryUnsigned() para um campo de um corpo JSON: false se o valor
+// não for um inteiro não negativo
+bool bodyUnsigned(const nlohmann::json &body, const char *key, uint64_t fallback, uint64_t &out)
 {
-    double probPercentage = prob * 100;
-    int random_number = rand() % 100;
-    return random_number < probPercentage;
+    if (!body.contains(key)) {
+        out = fallback;
+        return true;
+    }
+    if (!body[key].is_number_unsigned())
+        return false;
+    out = body[key].get<uint64_t>();
+    return true;
 }
-int randomNumber()  //utilizado para gerar uma direção aleatoria 
-{
-    int number = rand() % NUM_ROWS;
-    return number;
-} 
 
-void simulatePlant(int i, int j)
+// Colunas da grade pedidas em ?fields= (todas se ausente); responde 400 e
+// devolve false se a lista for inválida. Os endpoints que devolvem a grade
+// chamam antes de alterar o mundo.
+bool gridFields(const crow::request &req, crow::response &res, uint32_t &fields)
 {
-    std::unique_lock<std::mutex> lock(mtx_cv);// mutex para coordenar a entrada das threads, para que não cogestione (entre mais de uma de uma vez) 
-
-    while (true)
-    {
-        cv_thread.wait(lock); // Aguarda o sinal para começar a simulação
-
-        // Verifica se a planta está morta ou atingiu a idade máxima
-        if (entity_grid[i][j].type == morta || entity_grid[i][j].age >= PLANT_MAXIMUM_AGE)
-        {
-            // Remove a planta e decrementa o contador de entidades
-            entity_grid[i][j].type = empty;
-            entity_grid[i][j].age = 0;
-            mtx_total.lock(); // mutex para garantir a exclusã mutua ao total_entidades 
-            total_entidades--;
-            mtx_total.unlock();
-            break; // sai do loop
-        }
-
-        //calcula a probabilidade de reprodução da planta 
-        bool prob = getProbability(PLANT_REPRODUCTION_PROBABILITY);
-        
-        // Se a planta decidir se reproduzir
-        if (prob)
-        {
-            grid.lock();// Mutex para acessar a grade de entidades
-
-            // Gera uma direção aleatória
-            int direction = randomNumber() % 4; // 0: cima, 1: baixo, 2: esquerda, 3: direita
-            
-            // Verifica se a célula adjacente na direção escolhida está vazia e atualiza-a para uma nova planta
-            if (direction=0 && i + 1 < NUM_ROWS && entity_grid[i + 1][j].type == empty)
-            {
-                mtx_cout.lock(); // Mutex para evitar a mistura de saída no console
-                std::cout << "New plant i " << i + 1 << " j " << j << std::endl;
-                mtx_cout.unlock();
-                entity_grid[i + 1][j].type = plant;
-            }
-            else if (direction=1  && j + 1 < NUM_ROWS && entity_grid[i][j + 1].type == empty)
-            {
-                mtx_cout.lock();// Mutex para evitar a mistura de saída no console
-                std::cout << "New plant i " << i << " j " << j + 1 << std::endl;
-                mtx_cout.unlock();
-                entity_grid[i][j + 1].type = plant;
-            }
-            else if (direction=2 && j - 1 > 0 && entity_grid[i][j - 1].type == empty)
-            {
-                mtx_cout.lock(); // Mutex para evitar a mistura de saída no console
-                std::cout << "New plant i " << i << " j " << j - 1 << std::endl;
-                mtx_cout.unlock();
-                entity_grid[i][j - 1].type = plant;
-            }
-            else if ( direction=3 && i - 1 > 0 && entity_grid[i - 1][j].type == empty)
-            {
-                mtx_cout.lock(); // Mutex para evitar a mistura de saída no console
-                std::cout << "New plant i " << i - 1 << " j " << j << std::endl;
-                mtx_cout.unlock();
-                entity_grid[i - 1][j].type = plant;
-            }
-            grid.unlock(); // Libera o acesso à grade de entidades
-        }
-        entity_grid[i][j].age++; // Incrementa a idade da planta
-
-        mtx_counter.lock(); // Mutex para acessar e modificar iteracao_terminada
-        (*iteracao_terminada)++;  // Atualiza o contador de iterações concluídas
-        std::cout << "Iteração terminada: i " << i << " j " << j << std::endl;
-        cv_grid.notify_all(); // Notifica todas as threads aguardando na condição cv_grid
-        mtx_counter.unlock(); // Libera o acesso a iteracao_terminada
+    fields = GRID_FIELDS_ALL;
+    const char *list = req.url_params.get("fields");
+    if (!list)
+        return true;
+    try {
+        fields = parseGridFields(list);
+        return true;
+    } catch (const std::invalid_argument &e) {
+        res.code = 400;
+        res.body = e.what();
+        res.end();
+        return false;
     }
 }
 
-void simulateHerbivore(int i, int j)
+// Responde com as colunas `fields` da grade em JSON; com ?format=binary, no
+// formato binário de serialize.h (usado pela página para desenhar mundos
+// grandes), e com ?format=compact, no JSON compacto de writeGridCompactJson()
+void writeGrid(const crow::request &req, crow::response &res, const grid_t &grid, uint32_t fields)
 {
-    std::unique_lock<std::mutex> lock(mtx_cv); // Mutex para coordenar a entrada das threads
-
-    while (true)
-    {
-        cv_thread.wait(lock);// Aguarda o sinal para começar a simulação
-
-         // Verificar se o herbívoro está vivo, atingiu a idade máxima ou tem energia zero
-        if (entity_grid[i][j].type == morta || entity_grid[i][j].age >= HERBIVORE_MAXIMUM_AGE || entity_grid[i][j].energy <= 0)
-        {
-            // Remove o herbívoro, reiniciando suas propriedades, e decrementa o contador de entidades
-            entity_grid[i][j].type = empty;
-            entity_grid[i][j].age = 0;
-            entity_grid[i][j].energy = 0;
-            mtx_total.lock();// Mutex para garantir a exclusão mútua ao modificar total_entidades
-            total_entidades--;
-            mtx_total.unlock();
-            break;
-        }
-
-        // Movimento do herbivoro
-        if (getProbability(HERBIVORE_MOVE_PROBABILITY))
-        {
-            grid.lock();// Mutex para acessar a grade de entidade
+    phase_timer_t timer(&engine_metrics.phases[PHASE_SERIALIZE]);
+    trace_scope_t serialize_trace("serialize", "phase");
+    const char *format_param = req.url_params.get("format");
+    const std::string format = format_param ? format_param : "";
+    if (format == "binary") {
+        res.set_header("Content-Type", "application/octet-stream");
+        writeGridBinary(grid, res.body, fields);
+        return;
+    }
 
-            // Procurar uma célula adjacente vazia ou com planta para se mover
-            int direction = randomNumber() % 4; // 0: cima, 1: baixo, 2: esquerda, 3: direita
-            int newRow = i, newCol = j;
+    // reserva o tamanho da resposta anterior do mesmo formato, para o texto
+    // não crescer aos poucos
+    static std::atomic<size_t> json_size_hint[2] = {0, 0};
+    const bool compact = format == "compact";
+    res.set_header("Content-Type", "application/json");
+    res.body.reserve(json_size_hint[compact].load());
+    if (compact)
+        writeGridCompactJson(grid, res.body, fields);
+    else
+        writeGridJson(grid, res.body, fields);
+    json_size_hint[compact].store(res.body.size());
+}
 
-            if (direction == 0 && i > 0 && (entity_grid[i - 1][j].type == empty || entity_grid[i - 1][j].type == plant))
-            {
-                newRow = i - 1;
-                std::cout << "i-1" << (entity_grid[i - 1][j].type == empty) << std::endl;
-            }
-            else if (direction == 1 && i < NUM_ROWS - 1 && (entity_grid[i + 1][j].type == empty || entity_grid[i + 1][j].type == plant))
-            {
-                newRow = i + 1;
-                std::cout << "i+1" << (entity_grid[i + 1][j].type == empty) << std::endl;
-            }
-            else if (direction == 2 && j > 0 && (entity_grid[i][j - 1].type == empty || entity_grid[i][j - 1].type == plant))
-            {
-                newCol = j - 1;
-                std::cout << "j-1" << (entity_grid[i][j - 1].type == empty) << std::endl;
-            }
-            else if (direction == 3 && j < NUM_ROWS - 1 && (entity_grid[i][j + 1].type == empty || entity_grid[i][j + 1].type == plant))
-            {
-                newCol = j + 1;
-                std::cout << "j+1" << (entity_grid[i][j + 1].type == empty) << std::endl;
-            }
+// Histórico gravado com --record <arquivo>, recomeçado sempre que o mundo é
+// substituído (/start-simulation, /restore); protegido por mtx_world. Cada
+// recomeço grava em um arquivo novo, <arquivo>.1, <arquivo>.2, ..., pulando
+// os que já existem, então nenhuma gravação anterior é perdida. Só o arquivo
+// atual é lido por /replay; os antigos não são apagados (a rotação fica com
+// quem opera o servidor).
+static std::string history_path;
+static uint32_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL;
+static std::unique_ptr<history_log_t> history;
+static uint64_t history_run = 0;
+
+// (Re)começa o histórico a partir do estado atual do mundo. Um erro de
+// gravação desliga o histórico, mas não interrompe a simulação.
+void restartHistory()
+{
+    history.reset();
+    if (history_path.empty())
+        return;
+    std::string path;
+    struct stat st;
+    do
+        path = history_path + "." + std::to_string(++history_run);
+    while (stat(path.c_str(), &st) == 0);
+    try {
+        history = std::make_unique<history_log_t>(path, world, keyframe_interval);
+        std::cout << "Recording history to " << path << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "History recording disabled: " << e.what() << std::endl;
+    }
+}
 
-            // verifica se houve movimento
-            if (newRow != i || newCol != j)
-            {
-                // Se a nova célula contém uma planta, comer a planta
-                if (entity_grid[newRow][newCol].type == plant)
-                {
-                    // Comer a planta
-                    entity_grid[i][j].energy += 30;
-                    if (entity_grid[i][j].energy > 100)
-                        entity_grid[i][j].energy = 100; // Limitar a energia a 100 unidades
-                    entity_grid[newRow][newCol] = {empty, 0, 0}; // Remover a planta
-                }
-                // Mover o herbívoro para a nova célula
-                entity_grid[newRow][newCol] = {herbivore, entity_grid[i][j].energy - 5, 0}; // Mover o herbívoro
-                entity_grid[i][j] = {empty, 0, 0};                                          // Deixar a celula anterior vazia
-            }
-            else
-            {
-                // Se não houve movimento, decrementar a energia do herbivoro
-                entity_grid[i][j].energy -= 5; // Custo de energia para movimento sem sucesso
-            }
-            grid.unlock();
-        }
+// Populações de cada iteração para /history, recomeçadas junto com o
+// histórico; protegidas por mtx_world
+static population_series_t population_series;
 
-        // Alimentação do herbívoro
-        if (getProbability(HERBIVORE_EAT_PROBABILITY))
-        {
-            grid.lock();//mutex para acessaar a grade de entidades 
-
-            // Verificar se há uma planta adjacente para comer
-            if (i > 0 && entity_grid[i - 1][j].type == plant)
-            {
-                // comer a planta e atualizar a energia do herbivoro 
-                entity_grid[i - 1][j] = {empty, 0, 0}; // Remover a planta
-                entity_grid[i][j].energy += 30; 
-                if (entity_grid[i][j].energy > 100)
-                    entity_grid[i][j].energy = 100; // Limitar a energia a 100 unidades      // Ganhar energia ao comer a planta
-            }
-            else if (i < NUM_ROWS - 1 && entity_grid[i + 1][j].type == plant)
-            {
-                entity_grid[i + 1][j] = {empty, 0, 0}; // Remover a planta
-                entity_grid[i][j].energy += 30; 
-                if (entity_grid[i][j].energy > 100)
-                    entity_grid[i][j].energy = 100; // Limitar a energia a 100 unidades       // Ganhar energia ao comer a planta
-            }
-            else if (j > 0 && entity_grid[i][j - 1].type == plant)
-            {
-                entity_grid[i][j - 1] = {empty, 0, 0}; // Remover a planta
-                entity_grid[i][j].energy += 30; 
-                if (entity_grid[i][j].energy > 100)
-                    entity_grid[i][j].energy = 100; // Limitar a energia a 100 unidades       // Ganhar energia ao comer a planta
-            }
-            else if (j < NUM_ROWS - 1 && entity_grid[i][j + 1].type == plant)
-            {
-                entity_grid[i][j + 1] = {empty, 0, 0}; // Remover a planta
-                entity_grid[i][j].energy += 30;      
-                if (entity_grid[i][j].energy > 100)
-                    entity_grid[i][j].energy = 100; // Limitar a energia a 100 unidades  // Ganhar energia ao comer a planta
-            }
-            grid.unlock(); //libera o acesso a grade de entidades 
-        }
-
-        // Reprodução do herbívoro
-        if (entity_grid[i][j].energy > THRESHOLD_ENERGY_FOR_REPRODUCTION && getProbability(HERBIVORE_REPRODUCTION_PROBABILITY))
-        {
-            grid.lock(); //mutex para acessar a grade de entidades
+// Esquece a série e grava a primeira amostra, do estado atual do mundo
+void restartSeries()
+{
+    if (!world.stats.valid)
+        world.stats.rebuild(entity_grid);
+    population_series.clear();
+    population_series.record(populationSample(world));
+}
 
-            // Procurar uma célula adjacente vazia para colocar a prole
-            int direction = randomNumber() % 4; // 0: cima, 1: baixo, 2: esquerda, 3: direita
-            int newRow = i, newCol = j;
+// Varreduras de parâmetros disparadas por POST /sweep; cada uma roda em uma
+// thread própria, com um pool de todos os núcleos, então só
+// MAX_RUNNING_SWEEPS rodam ao mesmo tempo (os pedidos além disso recebem
+// 429). O resultado fica guardado até ser buscado ou por SWEEP_RESULT_TTL.
+static const size_t MAX_RUNNING_SWEEPS = 1;
+static const std::chrono::minutes SWEEP_RESULT_TTL{10};
 
-            if (direction == 0 && i > 0 && entity_grid[i - 1][j].type == empty)
-            {
-                newRow = i - 1;
-                std::cout << "i-1" << (entity_grid[i - 1][j].type == empty) << std::endl;
-            }
-            else if (direction == 1 && i < NUM_ROWS - 1 && entity_grid[i + 1][j].type == empty)
-            {
-                newRow = i + 1;
-                std::cout << "i+1" << (entity_grid[i + 1][j].type == empty) << std::endl;
-            }
-            else if (direction == 2 && j > 0 && entity_grid[i][j - 1].type == empty)
-            {
-                newCol = j - 1;
-                std::cout << "j-1" << (entity_grid[i][j - 1].type == empty) << std::endl;
-            }
-            else if (direction == 3 && j < NUM_ROWS - 1 && entity_grid[i][j + 1].type == empty)
-            {
-                newCol = j + 1;
-                std::cout << "j+1" << (entity_grid[i][j + 1].type == empty) << std::endl;
-            }
+struct sweep_job_t
+{
+    size_t runs = 0;
+    std::atomic<size_t> completed_runs{0};
+    bool done = false;
+    std::chrono::steady_clock::time_point finished_at;
+    std::string error;
+    std::string csv;
+};
+profiled_mutex_t mtx_jobs{"jobs"};
+static std::map<uint64_t, std::shared_ptr<sweep_job_t>> sweep_jobs;
+static uint64_t next_sweep_job = 1;
 
-            // Colocar na célula vazia adjacente
-            entity_grid[newRow][newCol] = {herbivore, entity_grid[i][j].energy - 10, 0}; //onde subtraii a energia do herbivoro caso ele mexa 
-            entity_grid[i][j].energy -= 10; //decrementa a energia do herbivoro caso atenda as necessidades 
-            grid.unlock(); // libera o acesso á grade de entidades 
+// Esquece os resultados não buscados há mais de SWEEP_RESULT_TTL e devolve
+// quantas varreduras ainda rodam; chamada com mtx_jobs travado
+size_t pruneSweepJobs()
+{
+    const auto now = std::chrono::steady_clock::now();
+    size_t running = 0;
+    for (auto it = sweep_jobs.begin(); it != sweep_jobs.end();) {
+        if (!it->second->done) {
+            running++;
+            ++it;
+        } else if (now - it->second->finished_at > SWEEP_RESULT_TTL) {
+            it = sweep_jobs.erase(it);
+        } else {
+            ++it;
         }
-
-        // Incrementar a idade do herbívoro
-        entity_grid[i][j].age++;
-
-        mtx_counter.lock(); // mutex para acessar e modificar iteração_terminada 
-        (*iteracao_terminada)++; // atualiza o contador de iterações concluidas 
-        std::cout << "Iteração terminada H: i " << i << " j " << j << std::endl;
-        cv_grid.notify_all(); // notifica todas as threads aguardando na condição cv_grid
-        mtx_counter.unlock(); //libera o acesso a iteracao_terminada 
     }
+    return running;
 }
 
-void simulateCarnivore(int i, int j)
+// Modo linha de comando: roda a varredura descrita no arquivo e sai
+int runSweepCommand(const std::string &spec_path, const std::string &output_path, unsigned threads)
 {
-    std::unique_lock<std::mutex> lock(mtx_cv); // mutex para coordenar a entrada das threads 
-    while (true)
-    {
-        cv_thread.wait(lock); // aguarda o sinal para começar a simulação
-
-        // Verificar se o carnívoro está vivo
-        if (entity_grid[i][j].type == morta || entity_grid[i][j].age >= CARNIVORE_MAXIMUM_AGE || entity_grid[i][j].energy <= 0)
-        {
-            //remove se o carnivoro, reinicia suas propriedades e decrementa o contador de entidades 
-            entity_grid[i][j].type = empty;
-            entity_grid[i][j].age = 0;
-            entity_grid[i][j].energy = 0;
-            mtx_total.lock(); //mutex para garantir a exclusao mutua do total_entidade 
-            total_entidades--;
-            mtx_total.unlock();
-            break;
-        }
-
-        // Movimento do carnívoro
-        if (getProbability(CARNIVORE_MOVE_PROBABILITY))
-        {
-            // Procurar uma célula adjacente vazia ou com herbívoro para se mover
-            int direction = randomNumber() % 4; // 0: cima, 1: baixo, 2: esquerda, 3: direita
-            int newRow = i, newCol = j;
-            grid.lock();// mutex para acessar a grade de entidades 
-            if (direction == 0 && i > 0 && (entity_grid[i - 1][j].type == empty || entity_grid[i - 1][j].type == herbivore))
-            {
-                newRow = i - 1;
-            }
-            else if (direction == 1 && i < NUM_ROWS - 1 && (entity_grid[i + 1][j].type == empty || entity_grid[i + 1][j].type == herbivore))
-            {
-                newRow = i + 1;
-            }
-            else if (direction == 2 && j > 0 && (entity_grid[i][j - 1].type == empty || entity_grid[i][j - 1].type == herbivore))
-            {
-                newCol = j - 1;
-            }
-            else if (direction == 3 && j < NUM_ROWS - 1 && (entity_grid[i][j + 1].type == empty || entity_grid[i][j + 1].type == herbivore))
-            {
-                newCol = j + 1;
-            }
-
-            // Verifica se houve movimento
-            if (newRow != i || newCol != j)
-            {
-                // Mover o carnívoro para a nova célula
-                entity_grid[newRow][newCol] = {carnivore, entity_grid[i][j].energy - 5, 0}; // Mover o carnívoro
-                entity_grid[i][j] = {empty, 0, 0};  
-                 if (entity_grid[i][j].energy > 100)
-                        entity_grid[i][j].energy = 100;  //limitar a energia                                      // Deixar a célula anterior vazia
-            }
-            else
-            {
-                // Se não houve movimento, decrementar a energia do carnívoro
-                entity_grid[i][j].energy -= 5; // Custo de energia para movimento sem sucesso
-            }
-            grid.unlock(); // libera o acesso a grade de entidades
+    try {
+        std::ifstream in(spec_path);
+        if (!in)
+            throw std::invalid_argument("cannot open sweep spec " + spec_path);
+        sweep_spec_t spec = parseSweepSpec(nlohmann::json::parse(in));
+        std::cerr << "Sweep: " << spec.runs() << " worlds of " << spec.rows << "x" << spec.cols
+                  << ", " << spec.ticks << " ticks" << std::endl;
+        if (output_path.empty()) {
+            runSweep(spec, threads, std::cout);
+        } else {
+            std::ofstream out(output_path);
+            if (!out)
+                throw std::invalid_argument("cannot write " + output_path);
+            runSweep(spec, threads, out);
         }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
-        // Alimentação do carnívoro
-        if (getProbability(CARNIVORE_EAT_PROBABILITY))
-        {
-            grid.lock();
-            // Verificar se há um herbívoro adjacente para comer
-            if (i > 0 && entity_grid[i - 1][j].type == herbivore)
-            {
-                entity_grid[i - 1][j] = {empty, 0, 0}; // Remover o herbívoro
-                entity_grid[i][j].energy += 20;       // Ganhar energia ao comer o herbívoro
-                 if (entity_grid[i][j].energy > 100)
-                        entity_grid[i][j].energy = 100;
-            }
-            else if (i < NUM_ROWS - 1 && entity_grid[i + 1][j].type == herbivore)
-            {
-                entity_grid[i + 1][j] = {empty, 0, 0}; // Remover o herbívoro
-                entity_grid[i][j].energy += 20;        // Ganhar energia ao comer o herbívoro
-                 if (entity_grid[i][j].energy > 100)
-                        entity_grid[i][j].energy = 100;
-            }
-            else if (j > 0 && entity_grid[i][j - 1].type == herbivore)
-            {
-                entity_grid[i][j - 1] = {empty, 0, 0}; // Remover o herbívoro
-                entity_grid[i][j].energy += 20;        // Ganhar energia ao comer o herbívoro
-                 if (entity_grid[i][j].energy > 100)
-                        entity_grid[i][j].energy = 100;
-            }
-            else if (j < NUM_ROWS - 1 && entity_grid[i][j + 1].type == herbivore)
-            {
-                entity_grid[i][j + 1] = {empty, 0, 0}; // Remover o herbívoro
-                entity_grid[i][j].energy += 20;        // Ganhar energia ao comer o herbívoro
-                 if (entity_grid[i][j].energy > 100)
-                        entity_grid[i][j].energy = 100;
-            }
-            grid.unlock(); //libera o acesso a grade de entidades 
+int main(int argc, char **argv)
+{
+    std::string sweep_path, output_path, restore_path;
+    unsigned threads = 0;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        if (arg == "--params" && a + 1 < argc) {
+            try {
+                default_params = loadParamsFile(argv[++a]);
+            } catch (const std::invalid_argument &e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        } else if (arg == "--sweep" && a + 1 < argc) {
+            sweep_path = argv[++a];
+        } else if (arg == "--output" && a + 1 < argc) {
+            output_path = argv[++a];
+        } else if (arg == "--restore" && a + 1 < argc) {
+            restore_path = argv[++a];
+        } else if (arg == "--checkpoint-dir" && a + 1 < argc) {
+            checkpoint_dir = argv[++a];
+        } else if (arg == "--record" && a + 1 < argc) {
+            history_path = argv[++a];
+        } else if (arg == "--keyframe-interval" && a + 1 < argc) {
+            uint64_t value;
+            if (!parseUnsigned(argv[++a], value) || value == 0 || value > UINT32_MAX) {
+                std::cerr << "--keyframe-interval must be an integer between 1 and " << UINT32_MAX << std::endl;
+                return 1;
+            }
+            keyframe_interval = (uint32_t)value;
+        } else if (arg == "--threads" && a + 1 < argc) {
+            uint64_t value;
+            if (!parseUnsigned(argv[++a], value) || value > MAX_SWEEP_THREADS) {
+                std::cerr << "--threads must be an integer between 0 (all cores) and " << MAX_SWEEP_THREADS << std::endl;
+                return 1;
+            }
+            threads = (unsigned)value;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--params <file.json>] [--restore <snapshot>] [--checkpoint-dir <dir>]"
+                      << " [--record <history.log> [--keyframe-interval N]]" << std::endl
+                      << "       " << argv[0] << " --sweep <spec.json> [--output <file.csv>] [--threads N]" << std::endl;
+            return 1;
         }
+    }
 
-        // Reprodução do carnívoro
-        if (entity_grid[i][j].energy > THRESHOLD_ENERGY_FOR_REPRODUCTION && getProbability(CARNIVORE_REPRODUCTION_PROBABILITY))
-        {
-            // Procurar uma célula adjacente vazia para colocar a prole
-            int direction = randomNumber() % 4; // 0: cima, 1: baixo, 2: esquerda, 3: direita
-            int newRow = i, newCol = j;
-            grid.lock();
-            if (direction == 0 && i > 0 && entity_grid[i - 1][j].type == empty)
-            {
-                newRow = i - 1;
-            }
-            else if (direction == 1 && i < NUM_ROWS - 1 && entity_grid[i + 1][j].type == empty)
-            {
-                newRow = i + 1;
-            }
-            else if (direction == 2 && j > 0 && entity_grid[i][j - 1].type == empty)
-            {
-                newCol = j - 1;
-            }
-            else if (direction == 3 && j < NUM_ROWS - 1 && entity_grid[i][j + 1].type == empty)
-            {
-                newCol = j + 1;
-            }
-
-            // Colocar na célula vazia adjacente
-            entity_grid[newRow][newCol] = {carnivore, entity_grid[i][j].energy - 10, 0};
-            entity_grid[i][j].energy -= 10;
-            grid.unlock(); //libera o acesso a grade de entidades
+    if (!sweep_path.empty())
+        return runSweepCommand(sweep_path, output_path, threads);
+
+    world.setParams(default_params);
+    world.metrics = &engine_metrics;
+    if (!restore_path.empty()) {
+        try {
+            loadSnapshot(world, restore_path);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
         }
-
-        // Incrementar a idade do carnívoro
-        entity_grid[i][j].age++;
-
-        mtx_counter.lock(); // mutex para acessar e modificr iteacao_termiinada
-        (*iteracao_terminada)++; // atualiza o contador de iteracoes concluidas 
-        std::cout << "Iteração terminada c: i " << i << " j " << j << std::endl;
-        cv_grid.notify_all();// notifica todas as threads guardando na cv_grid
-        mtx_counter.unlock(); // libera o acesso a iteracao_terminada 
+        std::cout << "Restored " << entity_grid.rows << "x" << entity_grid.cols << " world at tick " << world.tick
+                  << " from " << restore_path << std::endl;
     }
-}
+    restartHistory();
+    restartSeries();
 
-int main()
-{
-    srand(time(NULL)); // Inicialização do seed do gerador de números aleatórios
+    std::cout << "Kernel das plantas: " << plantKernelName() << std::endl;
+    worker_pool_t pool; // threads do motor, uma por núcleo
     crow::SimpleApp app;
 
     // Endpoint to serve the HTML page
@@ -480,159 +336,520 @@ int main()
         res.end(); });
 
     CROW_ROUTE(app, "/start-simulation")
-        .methods("POST"_method)([](crow::request &req, crow::response &res)
+        .methods("POST"_method)([&pool](crow::request &req, crow::response &res)
                                 {
+        trace_scope_t trace("/start-simulation", "http");
+        uint32_t fields;
+        if (!gridFields(req, res, fields))
+            return;
         // Parse the JSON request body
         nlohmann::json request_body = nlohmann::json::parse(req.body);
 
-       // Validate the request body
-        uint32_t total_entinties = (uint32_t)request_body["plants"] + (uint32_t)request_body["herbivores"] + (uint32_t)request_body["carnivores"];
-        if (total_entinties > NUM_ROWS * NUM_ROWS) {
-        res.code = 400;
-        res.body = "Too many entities";
-        res.end();
-        return;
+        // Tamanho opcional da grade (padrão NUM_ROWS x NUM_ROWS), conferido em
+        // 64 bits antes de estreitar, como em /start-simulation/density
+        uint64_t requested_rows, requested_cols;
+        if (!bodyUnsigned(request_body, "rows", NUM_ROWS, requested_rows) ||
+            !bodyUnsigned(request_body, "cols", NUM_ROWS, requested_cols) || requested_rows == 0 ||
+            requested_cols == 0 || requested_rows > UINT32_MAX || requested_cols > UINT32_MAX ||
+            requested_rows * requested_cols > MAX_GRID_CELLS) {
+            res.code = 400;
+            res.body = "rows and cols must be positive integers and rows * cols at most " + std::to_string(MAX_GRID_CELLS);
+            res.end();
+            return;
+        }
+        const uint32_t rows = (uint32_t)requested_rows, cols = (uint32_t)requested_cols;
+
+        // Com "noise" as entidades vêm de um mapa de densidade gerado por
+        // ruído (ver density.h) em vez das quantidades
+        bool use_noise = request_body.contains("noise");
+        noise_density_t noise;
+        if (use_noise) {
+            try {
+                noise = parseNoiseDensity(request_body["noise"]);
+            } catch (const std::invalid_argument &e) {
+                res.code = 400;
+                res.body = e.what();
+                res.end();
+                return;
+            }
+        } else {
+            // Validate the request body
+            uint64_t total_entinties = (uint64_t)request_body["plants"] + (uint64_t)request_body["herbivores"] + (uint64_t)request_body["carnivores"];
+            if (total_entinties > (uint64_t)rows * cols) {
+            res.code = 400;
+            res.body = "Too many entities";
+            res.end();
+            return;
+            }
         }
 
+        // Parâmetros opcionais das regras, aplicados sobre os padrão, e
+        // topologia opcional da grade
+        rule_params_t params = default_params;
+        topology_t topology;
+        try {
+            if (request_body.contains("parameters"))
+                mergeParams(params, request_body["parameters"]);
+            topology = parseTopology(request_body);
+            validateTopology(topology, rows, cols);
+        } catch (const std::invalid_argument &e) {
+            res.code = 400;
+            res.body = e.what();
+            res.end();
+            return;
+        }
+
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+
         // Clear the entity grid
-        entity_grid.clear();
-        entity_grid.assign(NUM_ROWS, std::vector<entity_t>(NUM_ROWS, { empty, 0, 0}));
+        world.reset(rows, cols, request_body.value("seed", (uint64_t)time(NULL)), topology);
+        world.setParams(params);
        
         // Create the entities
-        // <YOUR CODE HERE>
-
-        // Simula a próxima iteração
-        // Itera sobre a grade de entidades e simula o comportamento de cada entidade
-
-        for (int i = 0; i < (uint32_t)request_body["plants"]; i++) {
-            entity_t newPlant;
-            newPlant.age = 0;
-            newPlant.type = plant;
-            int foundPos = 0;
-            int row;
-            int col;
-            std::cout << i << std::endl;
-            while (foundPos == 0){
-                row = randomNumber();
-                col = randomNumber();
-                std::cout << entity_grid[row][col].type << std::endl;
-                if(entity_grid[row][col].type == empty) {
-                    entity_grid[row][col] = newPlant;
-                    foundPos = 1;
-                }
-            }
-        }
+        if (use_noise)
+            populateFromNoise(world, noise, pool);
+        else
+            placeEntities(world, request_body["plants"], request_body["herbivores"], request_body["carnivores"]);
+        restartHistory();
+        restartSeries();
+
+        // Return the entity grid
+        writeGrid(req, res, entity_grid, fields);
+        res.end(); });
 
-        for (int i = 0; i < (uint32_t)request_body["carnivores"]; i++) {
-            entity_t newCarnivore;
-            newCarnivore.age = 0;
-            newCarnivore.type = carnivore;
-            newCarnivore.energy = 100;
-            int foundPos = 0;
-            int row;
-            int col;
-            while (foundPos == 0){
-                row = randomNumber();
-                col = randomNumber();
-                if(entity_grid[row][col].type == empty) {
-                    entity_grid[row][col] = newCarnivore;
-                    foundPos = 1;
-                }
-            }
+    // Inicia a simulação a partir de um mapa de densidade binário (ver
+    // density.h) no corpo; tamanho da grade e semente vêm da query string
+    CROW_ROUTE(app, "/start-simulation/density")
+        .methods("POST"_method)([&pool](const crow::request &req, crow::response &res)
+                                {
+        trace_scope_t trace("/start-simulation/density", "http");
+        uint32_t fields;
+        if (!gridFields(req, res, fields))
+            return;
+        uint64_t rows, cols, seed;
+        if (!queryUnsigned(req, "seed", (uint64_t)time(NULL), seed)) {
+            res.code = 400;
+            res.body = "seed must be a non-negative integer";
+            res.end();
+            return;
         }
-
-        for (int i = 0; i < (uint32_t)request_body["herbivores"]; i++) {
-            entity_t newHerbivore;
-            newHerbivore.age = 0;
-            newHerbivore.type = herbivore;
-            newHerbivore.energy = 100;
-            int foundPos = 0;
-            int row;
-            int col;
-            while (foundPos == 0){
-                row = randomNumber();
-                col = randomNumber();
-                if(entity_grid[row][col].type == empty) {
-                    entity_grid[row][col] = newHerbivore;
-                    foundPos = 1;
-                }
-            }
+        // cada dimensão é conferida antes da multiplicação, que então não estoura
+        if (!queryUnsigned(req, "rows", NUM_ROWS, rows) || !queryUnsigned(req, "cols", NUM_ROWS, cols) ||
+            rows == 0 || cols == 0 || rows > UINT32_MAX || cols > UINT32_MAX || rows * cols > MAX_GRID_CELLS) {
+            res.code = 400;
+            res.body = "rows and cols must be positive integers and rows * cols at most " + std::to_string(MAX_GRID_CELLS);
+            res.end();
+            return;
+        }
+        density_raster_t raster;
+        topology_t topology;
+        try {
+            raster = parseDensityRaster(req.body);
+            nlohmann::json topology_fields = nlohmann::json::object();
+            for (const char *key : {"neighbourhood", "boundary"})
+                if (const char *v = req.url_params.get(key))
+                    topology_fields[key] = v;
+            topology = parseTopology(topology_fields);
+            validateTopology(topology, (uint32_t)rows, (uint32_t)cols);
+        } catch (const std::invalid_argument &e) {
+            res.code = 400;
+            res.body = e.what();
+            res.end();
+            return;
         }
-        // Return the JSON representation of the entity grid
-        nlohmann::json json_grid = entity_grid;
-        res.body = json_grid.dump();
+
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+        world.reset((uint32_t)rows, (uint32_t)cols, seed, topology);
+        world.setParams(default_params);
+        populateFromRaster(world, raster, pool);
+        restartHistory();
+        restartSeries();
+
+        writeGrid(req, res, entity_grid, fields);
         res.end(); });
 
     // Endpoint to process HTTP GET requests for the next simulation iteration
     CROW_ROUTE(app, "/next-iteration")
-        .methods("GET"_method)([]()
+        .methods("GET"_method)([&pool](const crow::request &req, crow::response &res)
                                {
-        // Simulate the next iteration
-        // Iterate over the entity grid and simulate the behaviour of each entity
-
-    
-        // Limpa o contador de iterações terminadas
-        mtx_counter.lock();
-        *iteracao_terminada = 0;
-        mtx_counter.unlock(); 
-
-        for (int i = 0; i < NUM_ROWS; i++) {
-            for (int j = 0; j < NUM_ROWS; j++) {
-                if (entity_grid[i][j].type == plant && entity_grid[i][j].age == 0) {
-                    // mtx_cout.lock();
-                    // std::cout << "Plant detected at position: (" << i << ", " << j << ")" << std::endl;
-                    // mtx_cout.unlock();
-                    std::thread p(simulatePlant,i,j);
-                    p.detach();
-                    mtx_total.lock();
-                    total_entidades++;
-                    mtx_total.unlock();
-                }if (entity_grid[i][j].type == herbivore && entity_grid[i][j].age == 0) {
-                    mtx_cout.lock();
-                        std::cout << "Herbivore detected at position: (" << i << ", " << j << ")" << std::endl;
-                        mtx_cout.unlock();
-                        std::thread h(simulateHerbivore,i,j);
-                        h.detach();
-                        mtx_total.lock();
-                    total_entidades++;
-                    mtx_total.unlock();
-                    }if (entity_grid[i][j].type == carnivore && entity_grid[i][j].age == 0) {
-                        mtx_cout.lock();
-                        std::cout << "Carnivore detected at position: (" << i << ", " << j << ")" << std::endl;
-                        mtx_cout.unlock();
-                        std::thread c(simulateCarnivore,i,j);
-                        c.detach();
-                                           mtx_total.lock();
-                    total_entidades++;
-                    mtx_total.unlock();
-                    }
-            }
-        }  
-
-    // Aguarda um curto período de tempo antes de notificar as threads de que a simulação da iteração terminou
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        std::unique_lock<std::mutex> lock2(mtx_wait_end);
-
-        cv_thread.notify_all();  // Notifica todas as threads esperando na condição cv_thread
-
-        // Aguarda até que todas as iterações terminem antes de continuar
-        while (true) {
-            cv_grid.wait(lock2);
-            mtx_counter.lock();
-            int it = *iteracao_terminada;
-            std::cout << it << " total " << total_entidades << std::endl;
-            mtx_counter.unlock();
-            if (it >= total_entidades) {
-                break;
+        trace_scope_t trace("/next-iteration", "http");
+        uint32_t fields;
+        if (!gridFields(req, res, fields))
+            return;
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+
+        // Simulate the next iteration: fase das plantas e fase dos animais
+        simulateTick(world, pool);
+        population_series.record(populationSample(world));
+        if (history) {
+            phase_timer_t timer(&engine_metrics.phases[PHASE_RECORD]);
+            trace_scope_t record_trace("record", "phase");
+            try {
+                history->append(world);
+            } catch (const std::exception &e) {
+                std::cerr << "History recording disabled: " << e.what() << std::endl;
+                history.reset();
             }
         }
-      
 
-       
-        // Return the JSON representation of the entity grid
-        nlohmann::json json_grid = entity_grid;
-        return json_grid.dump(); });
-    app.port(8080).run();
+        // Return the entity grid
+        writeGrid(req, res, entity_grid, fields);
+        res.end(); });
+    // Parâmetros das regras em vigor; o POST troca só os campos enviados e vale
+    // a partir da próxima iteração
+    CROW_ROUTE(app, "/parameters")
+        .methods("GET"_method, "POST"_method)([](const crow::request &req, crow::response &res)
+                                              {
+        trace_scope_t trace("/parameters", "http");
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+        if (req.method == "POST"_method) {
+            rule_params_t params = world.params;
+            try {
+                mergeParams(params, nlohmann::json::parse(req.body));
+            } catch (const std::exception &e) {
+                res.code = 400;
+                res.body = e.what();
+                res.end();
+                return;
+            }
+            world.setParams(params);
+        }
+        res.body = paramsToJson(world.params).dump();
+        res.end(); });
+
+    // Grava o estado completo do mundo em um snapshot binário (ver snapshot.h)
+    CROW_ROUTE(app, "/checkpoint")
+        .methods("POST"_method)([](const crow::request &req, crow::response &res)
+                                {
+        trace_scope_t trace("/checkpoint", "http");
+        std::string path = snapshotPath(req);
+        if (path.empty()) {
+            res.code = 400;
+            res.body = "invalid snapshot name";
+            res.end();
+            return;
+        }
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+        try {
+            uint64_t bytes = saveSnapshot(world, path);
+            res.body = nlohmann::json{{"file", path}, {"tick", world.tick}, {"bytes", bytes}}.dump();
+        } catch (const std::exception &e) {
+            res.code = 500;
+            res.body = e.what();
+        }
+        res.end(); });
+
+    // Volta ao estado gravado por /checkpoint; a próxima iteração continua
+    // exatamente de onde o snapshot parou
+    CROW_ROUTE(app, "/restore")
+        .methods("POST"_method)([](const crow::request &req, crow::response &res)
+                                {
+        trace_scope_t trace("/restore", "http");
+        std::string path = snapshotPath(req);
+        if (path.empty()) {
+            res.code = 400;
+            res.body = "invalid snapshot name";
+            res.end();
+            return;
+        }
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+        try {
+            loadSnapshot(world, path);
+        } catch (const std::exception &e) {
+            res.code = 400;
+            res.body = e.what();
+            res.end();
+            return;
+        }
+        restartHistory();
+        restartSeries();
+        res.body = nlohmann::json{{"file", path}, {"tick", world.tick}, {"rows", entity_grid.rows}, {"cols", entity_grid.cols}}.dump();
+        res.end(); });
+
+    // Estado de uma iteração passada, reconstruído do histórico gravado
+    // (--record) a partir do quadro-chave anterior mais próximo
+    CROW_ROUTE(app, "/replay")
+        .methods("GET"_method)([](const crow::request &req, crow::response &res)
+                               {
+        trace_scope_t trace("/replay", "http");
+        uint32_t fields;
+        if (!gridFields(req, res, fields))
+            return;
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+        if (!history) {
+            res.code = 404;
+            res.body = "history recording is disabled (start the server with --record <file>)";
+            res.end();
+            return;
+        }
+        const char *tick_param = req.url_params.get("tick");
+        char *end = nullptr;
+        uint64_t tick = tick_param ? std::strtoull(tick_param, &end, 10) : 0;
+        if (!tick_param || *tick_param == '\0' || *end != '\0') {
+            res.code = 400;
+            res.body = "tick must be a non-negative integer";
+            res.end();
+            return;
+        }
+        grid_t past;
+        try {
+            history->replay(tick, past);
+        } catch (const std::out_of_range &e) {
+            res.code = 404;
+            res.body = e.what();
+            res.end();
+            return;
+        } catch (const std::exception &e) {
+            res.code = 500;
+            res.body = e.what();
+            res.end();
+            return;
+        }
+        writeGrid(req, res, past, fields);
+        res.end(); });
+
+    // Série das populações e energias médias entre as iterações from e to,
+    // por iteração ou em médias de 10 ou 100 (resolution)
+    CROW_ROUTE(app, "/history")
+        .methods("GET"_method)([](const crow::request &req, crow::response &res)
+                               {
+        trace_scope_t trace("/history", "http");
+        uint64_t from, to, resolution;
+        if (!queryUnsigned(req, "from", 0, from) || !queryUnsigned(req, "to", UINT64_MAX, to) ||
+            !queryUnsigned(req, "resolution", 1, resolution)) {
+            res.code = 400;
+            res.body = "from, to and resolution must be non-negative integers";
+            res.end();
+            return;
+        }
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+        try {
+            res.body = population_series.query(from, to, (uint32_t)std::min<uint64_t>(resolution, UINT32_MAX)).dump();
+        } catch (const std::invalid_argument &e) {
+            res.code = 400;
+            res.body = e.what();
+            res.end();
+            return;
+        }
+        res.set_header("Content-Type", "application/json");
+        res.end(); });
+
+    // Janela da grade para mundos grandes: com scale=1 devolve as células de
+    // [y, y + h) x [x, x + w); com scale = 2^k, as contagens por espécie dos
+    // blocos de scale x scale células, lidas da pirâmide mantida pelo motor.
+    // x e y são arredondados para um múltiplo de scale e w, h contam blocos.
+    CROW_ROUTE(app, "/view")
+        .methods("GET"_method)([](const crow::request &req, crow::response &res)
+                               {
+        trace_scope_t trace("/view", "http");
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+        uint64_t x, y, w, h, scale;
+        if (!queryUnsigned(req, "x", 0, x) || !queryUnsigned(req, "y", 0, y) || !queryUnsigned(req, "scale", 1, scale) ||
+            !queryUnsigned(req, "w", UINT32_MAX, w) || !queryUnsigned(req, "h", UINT32_MAX, h)) {
+            res.code = 400;
+            res.body = "x, y, w, h and scale must be non-negative integers";
+            res.end();
+            return;
+        }
+        if (!world.views.active())
+            world.views.rebuild(entity_grid);
+        if (scale == 0 || (scale & (scale - 1)) || scale > world.views.maxScale()) {
+            res.code = 400;
+            res.body = "scale must be a power of two up to " + std::to_string(world.views.maxScale());
+            res.end();
+            return;
+        }
+        const uint64_t block_rows = (entity_grid.rows + scale - 1) / scale;
+        const uint64_t block_cols = (entity_grid.cols + scale - 1) / scale;
+        const uint64_t by = y / scale, bx = x / scale;
+        if (by >= block_rows || bx >= block_cols) {
+            res.code = 400;
+            res.body = "x and y must be inside the grid";
+            res.end();
+            return;
+        }
+        h = std::min(h, block_rows - by);
+        w = std::min(w, block_cols - bx);
+        if (w * h > MAX_VIEW_BLOCKS) {
+            res.code = 400;
+            res.body = "w * h must be at most " + std::to_string(MAX_VIEW_BLOCKS);
+            res.end();
+            return;
+        }
+
+        nlohmann::json view = {{"x", bx * scale}, {"y", by * scale}, {"scale", scale}, {"rows", h}, {"cols", w}};
+        phase_timer_t timer(&engine_metrics.phases[PHASE_SERIALIZE]);
+        trace_scope_t serialize_trace("serialize", "phase");
+        if (scale == 1) {
+            nlohmann::json cells = nlohmann::json::array();
+            for (uint32_t i = (uint32_t)by; i < by + h; i++) {
+                nlohmann::json row = nlohmann::json::array();
+                for (uint32_t j = (uint32_t)bx; j < bx + w; j++)
+                    row.push_back(entity_grid.get(i, j));
+                cells.push_back(std::move(row));
+            }
+            view["cells"] = std::move(cells);
+        } else {
+            // Contagens de plantas, herbívoros e carnívoros de cada bloco,
+            // linha por linha
+            std::vector<uint32_t> counts;
+            world.views.query(entity_grid, (uint32_t)scale, (uint32_t)by, (uint32_t)bx, (uint32_t)h, (uint32_t)w, counts);
+            view["counts"] = counts;
+        }
+        res.set_header("Content-Type", "application/json");
+        res.body = view.dump();
+        res.end(); });
+
+    // Dispara uma varredura de parâmetros em segundo plano (ver sweep.h)
+    CROW_ROUTE(app, "/sweep")
+        .methods("POST"_method)([](const crow::request &req, crow::response &res)
+                                {
+        trace_scope_t trace("/sweep", "http");
+        sweep_spec_t spec;
+        try {
+            spec = parseSweepSpec(nlohmann::json::parse(req.body));
+        } catch (const std::exception &e) {
+            res.code = 400;
+            res.body = e.what();
+            res.end();
+            return;
+        }
+
+        auto job = std::make_shared<sweep_job_t>();
+        job->runs = spec.runs();
+        uint64_t id;
+        {
+            std::lock_guard<profiled_mutex_t> lock(mtx_jobs);
+            if (pruneSweepJobs() >= MAX_RUNNING_SWEEPS) {
+                res.code = 429;
+                res.body = "another sweep is running; try again when it finishes";
+                res.end();
+                return;
+            }
+            id = next_sweep_job++;
+            sweep_jobs[id] = job;
+        }
+        std::thread([job, spec]() {
+            std::ostringstream csv;
+            std::string error;
+            try {
+                runSweep(spec, 0, csv, &job->completed_runs);
+            } catch (const std::exception &e) {
+                error = e.what();
+            }
+            std::lock_guard<profiled_mutex_t> lock(mtx_jobs);
+            job->csv = csv.str();
+            job->error = error;
+            job->done = true;
+            job->finished_at = std::chrono::steady_clock::now();
+        }).detach();
+
+        res.code = 202;
+        res.body = nlohmann::json{{"job", id}, {"runs", job->runs}}.dump();
+        res.end(); });
+
+    // Estado de uma varredura; quando termina, devolve o CSV (ou o erro) uma
+    // única vez e a esquece
+    CROW_ROUTE(app, "/sweep/<uint>")
+        .methods("GET"_method)([](const crow::request &, crow::response &res, uint64_t id)
+                               {
+        trace_scope_t trace("/sweep/<id>", "http");
+        std::lock_guard<profiled_mutex_t> lock(mtx_jobs);
+        pruneSweepJobs();
+        auto it = sweep_jobs.find(id);
+        if (it == sweep_jobs.end()) {
+            res.code = 404;
+            res.end();
+            return;
+        }
+        const sweep_job_t &job = *it->second;
+        if (!job.done) {
+            res.code = 202;
+            res.body = nlohmann::json{{"job", id}, {"runs", job.runs}, {"completed", job.completed_runs.load()}}.dump();
+        } else if (!job.error.empty()) {
+            res.code = 500;
+            res.body = job.error;
+        } else {
+            res.set_header("Content-Type", "text/csv");
+            res.body = std::move(it->second->csv);
+        }
+        if (job.done)
+            sweep_jobs.erase(it);
+        res.end(); });
+
+    // Estatísticas das populações mantidas pelo motor (ver stats.h): poucas
+    // centenas de bytes, em vez da grade inteira
+    CROW_ROUTE(app, "/stats")
+        .methods("GET"_method)([](const crow::request &, crow::response &res)
+                               {
+        trace_scope_t trace("/stats", "http");
+        std::lock_guard<profiled_mutex_t> lock(mtx_world);
+        if (!world.stats.valid)
+            world.stats.rebuild(entity_grid);
+        res.set_header("Content-Type", "application/json");
+        res.body = statsToJson(world.stats, entity_grid, world.tick).dump();
+        res.end(); });
+
+    // Métricas no formato texto do Prometheus: populações, energia média e
+    // idades dos animais, iterações por segundo e histogramas das durações
+    // de cada fase
+    CROW_ROUTE(app, "/metrics")
+        .methods("GET"_method)([](const crow::request &, crow::response &res)
+                               {
+        trace_scope_t trace("/metrics", "http");
+        std::string body;
+        {
+            std::lock_guard<profiled_mutex_t> lock(mtx_world);
+            char line[128];
+            body += "# HELP ecosim_population Entities of each species in the grid.\n# TYPE ecosim_population gauge\n";
+            const std::pair<entity_type_t, const char *> species[] = {{plant, "plant"}, {herbivore, "herbivore"}, {carnivore, "carnivore"}};
+            for (const auto &s : species) {
+                std::snprintf(line, sizeof(line), "ecosim_population{species=\"%s\"} %zu\n", s.second,
+                              entity_grid.population(s.first));
+                body += line;
+            }
+            body += "# HELP ecosim_tick Current simulation tick.\n# TYPE ecosim_tick gauge\n";
+            std::snprintf(line, sizeof(line), "ecosim_tick %llu\n", (unsigned long long)world.tick);
+            body += line;
+            if (!world.stats.valid)
+                world.stats.rebuild(entity_grid);
+            writeStatsPrometheus(world.stats, body);
+        }
+        engine_metrics.writePrometheus(body);
+        writeLockMetrics(body);
+        res.set_header("Content-Type", "text/plain; version=0.0.4");
+        res.body = std::move(body);
+        res.end(); });
+
+    // Grava um Chrome trace (chrome://tracing ou ui.perfetto.dev) das fases,
+    // das faixas e dos handlers HTTP durante `seconds` segundos
+    CROW_ROUTE(app, "/debug/trace")
+        .methods("GET"_method)([](const crow::request &req, crow::response &res)
+                               {
+        double seconds = 5;
+        if (req.url_params.get("seconds"))
+            seconds = std::atof(req.url_params.get("seconds"));
+        if (!(seconds > 0 && seconds <= MAX_TRACE_SECONDS)) {
+            res.code = 400;
+            res.body = "seconds must be in (0, " + std::to_string((int)MAX_TRACE_SECONDS) + "]";
+            res.end();
+            return;
+        }
+        std::string trace;
+        if (!captureTrace(seconds, trace)) {
+            res.code = 409;
+            res.body = "a trace capture is already running";
+            res.end();
+            return;
+        }
+        res.set_header("Content-Type", "application/json");
+        res.set_header("Content-Disposition", "attachment; filename=\"ecosim-trace.json\"");
+        res.body = std::move(trace);
+        res.end(); });
+
+    // /debug/trace ocupa uma thread durante a captura, então sempre há mais
+    // de uma para atender as outras requisições
+    app.port(8080).concurrency(std::max(HTTP_MIN_THREADS, std::thread::hardware_concurrency())).run();
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "metrics.h"
+#include <cstdio>
+#include <deque>
+
+const double duration_histogram_t::BUCKET_BOUNDS[BUCKET_COUNT] = {
+    1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4, 1e-3, 2.5e-3,
+    5e-3, 1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+
+void duration_histogram_t::record(std::chrono::steady_clock::duration d)
+{
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    double seconds = (double)ns * 1e-9;
+    size_t b = 0;
+    while (b < BUCKET_COUNT && seconds > BUCKET_BOUNDS[b])
+        b++;
+    buckets[b].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum_ns.fetch_add(ns, std::memory_order_relaxed);
+}
+
+void duration_histogram_t::writePrometheus(std::string &out, const char *name, const std::string &labels) const
+{
+    char line[256];
+    const char *sep = labels.empty() ? "" : ",";
+    uint64_t cumulative = 0;
+    for (size_t b = 0; b <= BUCKET_COUNT; b++)
+    {
+        cumulative += buckets[b].load(std::memory_order_relaxed);
+        if (b < BUCKET_COUNT)
+            std::snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"%g\"} %llu\n", name, labels.c_str(), sep,
+                          BUCKET_BOUNDS[b], (unsigned long long)cumulative);
+        else
+            std::snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels.c_str(), sep,
+                          (unsigned long long)cumulative);
+        out += line;
+    }
+    const char *open = labels.empty() ? "" : "{";
+    const char *close = labels.empty() ? "" : "}";
+    std::snprintf(line, sizeof(line), "%s_sum%s%s%s %.9f\n%s_count%s%s%s %llu\n", name, open, labels.c_str(), close,
+                  sumSeconds(), name, open, labels.c_str(), close, (unsigned long long)count());
+    out += line;
+}
+
+const char *tickPhaseName(tick_phase_t phase)
+{
+    switch (phase)
+    {
+    case PHASE_SCHEDULE:
+        return "schedule";
+    case PHASE_PLANTS:
+        return "plants";
+    case PHASE_ANIMALS:
+        return "animals";
+    case PHASE_SERIALIZE:
+        return "serialize";
+    case PHASE_RECORD:
+        return "record";
+    case PHASE_VIEWS:
+        return "views";
+    case PHASE_MOVEMENT:
+        return "movement";
+    default:
+        return "unknown";
+    }
+}
+
+void engine_metrics_t::recordTick(std::chrono::steady_clock::time_point end)
+{
+    tick_count.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mtx_rate);
+    tick_ends[recorded_ends % TICK_RATE_WINDOW] = end;
+    recorded_ends++;
+}
+
+double engine_metrics_t::ticksPerSecond() const
+{
+    std::lock_guard<std::mutex> lock(mtx_rate);
+    if (recorded_ends < 2)
+        return 0.0;
+    size_t n = recorded_ends < TICK_RATE_WINDOW ? recorded_ends : TICK_RATE_WINDOW;
+    auto newest = tick_ends[(recorded_ends - 1) % TICK_RATE_WINDOW];
+    auto oldest = tick_ends[(recorded_ends - n) % TICK_RATE_WINDOW];
+    double seconds = std::chrono::duration<double>(newest - oldest).count();
+    return seconds > 0 ? (double)(n - 1) / seconds : 0.0;
+}
+
+void engine_metrics_t::writePrometheus(std::string &out) const
+{
+    char line[128];
+    out += "# HELP ecosim_ticks_total Simulation ticks executed.\n# TYPE ecosim_ticks_total counter\n";
+    std::snprintf(line, sizeof(line), "ecosim_ticks_total %llu\n", (unsigned long long)tick_count.load());
+    out += line;
+
+    out += "# HELP ecosim_ticks_per_second Tick rate over the last ticks.\n# TYPE ecosim_ticks_per_second gauge\n";
+    std::snprintf(line, sizeof(line), "ecosim_ticks_per_second %g\n", ticksPerSecond());
+    out += line;
+
+    out += "# HELP ecosim_tick_seconds Duration of a whole simulation tick.\n# TYPE ecosim_tick_seconds histogram\n";
+    ticks.writePrometheus(out, "ecosim_tick_seconds", "");
+
+    out += "# HELP ecosim_tick_phase_seconds Duration of each tick phase.\n# TYPE ecosim_tick_phase_seconds histogram\n";
+    for (size_t p = 0; p < TICK_PHASE_COUNT; p++)
+        phases[p].writePrometheus(out, "ecosim_tick_phase_seconds",
+                                  std::string("phase=\"") + tickPhaseName((tick_phase_t)p) + "\"");
+}
+
+namespace
+{
+    // deque: as referências devolvidas por lockStats() continuam válidas
+    std::mutex &lockRegistryMutex()
+    {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    std::deque<lock_stats_t> &lockRegistry()
+    {
+        static std::deque<lock_stats_t> registry;
+        return registry;
+    }
+}
+
+lock_stats_t &lockStats(const char *name)
+{
+    std::lock_guard<std::mutex> lock(lockRegistryMutex());
+    for (lock_stats_t &stats : lockRegistry())
+        if (stats.name == name)
+            return stats;
+    lockRegistry().emplace_back();
+    lockRegistry().back().name = name;
+    return lockRegistry().back();
+}
+
+void writeLockMetrics(std::string &out)
+{
+    std::lock_guard<std::mutex> lock(lockRegistryMutex());
+    char line[160];
+    out += "# HELP ecosim_lock_acquisitions_total Lock acquisitions.\n# TYPE ecosim_lock_acquisitions_total counter\n";
+    for (const lock_stats_t &stats : lockRegistry())
+    {
+        std::snprintf(line, sizeof(line), "ecosim_lock_acquisitions_total{lock=\"%s\"} %llu\n", stats.name.c_str(),
+                      (unsigned long long)stats.acquisitions.load());
+        out += line;
+    }
+    out += "# HELP ecosim_lock_contended_total Lock acquisitions that had to wait.\n# TYPE ecosim_lock_contended_total counter\n";
+    for (const lock_stats_t &stats : lockRegistry())
+    {
+        std::snprintf(line, sizeof(line), "ecosim_lock_contended_total{lock=\"%s\"} %llu\n", stats.name.c_str(),
+                      (unsigned long long)stats.contended.load());
+        out += line;
+    }
+    out += "# HELP ecosim_lock_wait_seconds Time spent waiting for a contended lock.\n# TYPE ecosim_lock_wait_seconds histogram\n";
+    for (const lock_stats_t &stats : lockRegistry())
+        stats.wait.writePrometheus(out, "ecosim_lock_wait_seconds", "lock=\"" + stats.name + "\"");
+    out += "# HELP ecosim_lock_hold_seconds Time a lock was held.\n# TYPE ecosim_lock_hold_seconds histogram\n";
+    for (const lock_stats_t &stats : lockRegistry())
+        stats.hold.writePrometheus(out, "ecosim_lock_hold_seconds", "lock=\"" + stats.name + "\"");
+}
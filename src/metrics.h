@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Histograma de durações com baldes fixos em escala exponencial. record()
+// só faz incrementos atômicos relaxados, então pode ser chamado de qualquer
+// thread no caminho quente sem travas.
+class duration_histogram_t
+{
+public:
+    static const size_t BUCKET_COUNT = 22;
+    static const double BUCKET_BOUNDS[BUCKET_COUNT]; // limites superiores, em segundos
+
+    void record(std::chrono::steady_clock::duration d);
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    double sumSeconds() const { return (double)sum_ns.load(std::memory_order_relaxed) * 1e-9; }
+
+    // Acrescenta as linhas _bucket/_sum/_count no formato texto do Prometheus;
+    // `labels` é uma lista como `phase="plants"` (pode ser vazia)
+    void writePrometheus(std::string &out, const char *name, const std::string &labels) const;
+
+private:
+    std::atomic<uint64_t> buckets[BUCKET_COUNT + 1] = {}; // o último é +Inf
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum_ns{0};
+};
+
+// Fases de uma iteração medidas separadamente
+enum tick_phase_t
+{
+    PHASE_SCHEDULE,  // preparação das fases (sementes, marcações)
+    PHASE_PLANTS,    // kernel das plantas
+    PHASE_ANIMALS,   // faixas dos animais no pool de threads
+    PHASE_SERIALIZE, // conversão da grade para a resposta HTTP
+    PHASE_RECORD,    // gravação no histórico (--record)
+    PHASE_VIEWS,     // atualização das contagens por bloco de /view
+    PHASE_MOVEMENT,  // pedidos e resolução do movimento dos animais
+    TICK_PHASE_COUNT
+};
+
+const char *tickPhaseName(tick_phase_t phase);
+
+// Métricas do motor de um mundo
+struct engine_metrics_t
+{
+    duration_histogram_t phases[TICK_PHASE_COUNT];
+    duration_histogram_t ticks; // simulateTick() inteiro
+    std::atomic<uint64_t> tick_count{0};
+
+    // Marca o fim de uma iteração, para o cálculo de iterações por segundo
+    void recordTick(std::chrono::steady_clock::time_point end);
+
+    // Média das últimas TICK_RATE_WINDOW iterações (0 se ainda não houver)
+    double ticksPerSecond() const;
+
+    void writePrometheus(std::string &out) const;
+
+private:
+    static const size_t TICK_RATE_WINDOW = 32;
+    mutable std::mutex mtx_rate;
+    std::chrono::steady_clock::time_point tick_ends[TICK_RATE_WINDOW];
+    size_t recorded_ends = 0;
+};
+
+// Mede o tempo de vida do objeto e registra no histograma, se houver
+class phase_timer_t
+{
+public:
+    explicit phase_timer_t(duration_histogram_t *histogram)
+        : histogram(histogram), start(histogram ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+    {
+    }
+
+    ~phase_timer_t()
+    {
+        if (histogram)
+            histogram->record(std::chrono::steady_clock::now() - start);
+    }
+
+    phase_timer_t(const phase_timer_t &) = delete;
+    phase_timer_t &operator=(const phase_timer_t &) = delete;
+
+private:
+    duration_histogram_t *histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Contadores de uma trava com nome; todas as travas com o mesmo nome (ex.:
+// as de vários pools de threads) somam nos mesmos contadores
+struct lock_stats_t
+{
+    std::string name;
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0}; // aquisições que precisaram esperar
+    duration_histogram_t wait;           // espera das aquisições disputadas
+    duration_histogram_t hold;           // tempo com a trava
+};
+
+// Contadores registrados sob `name`, criados na primeira chamada
+lock_stats_t &lockStats(const char *name);
+
+// Métricas de todas as travas registradas, no formato texto do Prometheus
+void writeLockMetrics(std::string &out);
+
+// std::mutex que conta aquisições e mede espera e posse. Atende aos
+// requisitos de Lockable, então funciona com lock_guard, unique_lock e
+// std::condition_variable_any (o tempo dentro de wait() não conta como posse).
+class profiled_mutex_t
+{
+public:
+    explicit profiled_mutex_t(const char *name) : stats(lockStats(name)) {}
+
+    profiled_mutex_t(const profiled_mutex_t &) = delete;
+    profiled_mutex_t &operator=(const profiled_mutex_t &) = delete;
+
+    void lock()
+    {
+        if (!mtx.try_lock())
+        {
+            auto start = std::chrono::steady_clock::now();
+            mtx.lock();
+            acquired_at = std::chrono::steady_clock::now();
+            stats.contended.fetch_add(1, std::memory_order_relaxed);
+            stats.wait.record(acquired_at - start);
+        }
+        else
+        {
+            acquired_at = std::chrono::steady_clock::now();
+        }
+        stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool try_lock()
+    {
+        if (!mtx.try_lock())
+            return false;
+        acquired_at = std::chrono::steady_clock::now();
+        stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void unlock()
+    {
+        stats.hold.record(std::chrono::steady_clock::now() - acquired_at);
+        mtx.unlock();
+    }
+
+private:
+    std::mutex mtx;
+    lock_stats_t &stats;
+    std::chrono::steady_clock::time_point acquired_at; // só lido e escrito por quem tem a trava
+};
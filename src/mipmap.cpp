@@ -0,0 +1,123 @@
+#include "mipmap.h"
+#include <algorithm>
+
+namespace
+{
+    // Conta as espécies das células [row0, row1) x [col0, col1)
+    void countCells(const grid_t &grid, uint32_t row0, uint32_t row1, uint32_t col0, uint32_t col1, uint32_t *out)
+    {
+        uint32_t counts[ENTITY_TYPE_COUNT] = {};
+        for (uint32_t i = row0; i < row1; i++)
+        {
+            const uint8_t *r = grid.type.data() + grid.index(i, 0);
+            for (uint32_t j = col0; j < col1; j++)
+                counts[r[j]]++;
+        }
+        for (size_t s = 0; s < VIEW_SPECIES_COUNT; s++)
+            out[s] = counts[VIEW_SPECIES[s]];
+    }
+}
+
+void view_mipmap_t::countBase(const grid_t &grid, uint32_t i, uint32_t j)
+{
+    const uint32_t size = 1u << VIEW_BASE_SHIFT;
+    countCells(grid, i * size, std::min((i + 1) * size, grid.rows), j * size, std::min((j + 1) * size, grid.cols),
+               levels[0].block(i, j));
+}
+
+void view_mipmap_t::sumChildren(size_t k, uint32_t i, uint32_t j)
+{
+    const level_t &child = levels[k - 1];
+    uint32_t *out = levels[k].block(i, j);
+    std::fill(out, out + VIEW_SPECIES_COUNT, 0u);
+    for (uint32_t ci = 2 * i; ci < std::min(2 * i + 2, child.rows); ci++)
+        for (uint32_t cj = 2 * j; cj < std::min(2 * j + 2, child.cols); cj++)
+            for (size_t s = 0; s < VIEW_SPECIES_COUNT; s++)
+                out[s] += child.block(ci, cj)[s];
+}
+
+void view_mipmap_t::rebuild(grid_t &grid)
+{
+    levels.clear();
+    for (uint32_t shift = VIEW_BASE_SHIFT;; shift++)
+    {
+        level_t level;
+        level.shift = shift;
+        level.rows = (uint32_t)(((uint64_t)grid.rows + (1ull << shift) - 1) >> shift);
+        level.cols = (uint32_t)(((uint64_t)grid.cols + (1ull << shift) - 1) >> shift);
+        level.counts.assign((size_t)level.rows * level.cols * VIEW_SPECIES_COUNT, 0);
+        level.dirty.assign(level.rows, level.cols);
+        levels.push_back(std::move(level));
+        if (levels.back().rows <= 1 && levels.back().cols <= 1)
+            break;
+    }
+
+    for (uint32_t i = 0; i < levels[0].rows; i++)
+        for (uint32_t j = 0; j < levels[0].cols; j++)
+            countBase(grid, i, j);
+    for (size_t k = 1; k < levels.size(); k++)
+        for (uint32_t i = 0; i < levels[k].rows; i++)
+            for (uint32_t j = 0; j < levels[k].cols; j++)
+                sumChildren(k, i, j);
+    grid.changed.clear();
+}
+
+void view_mipmap_t::update(grid_t &grid)
+{
+    if (!active())
+        return;
+    if (levels[0].rows != (grid.rows + (1u << VIEW_BASE_SHIFT) - 1) >> VIEW_BASE_SHIFT ||
+        levels[0].cols != (grid.cols + (1u << VIEW_BASE_SHIFT) - 1) >> VIEW_BASE_SHIFT)
+    {
+        rebuild(grid);
+        return;
+    }
+
+    // Células alteradas -> blocos do nível base -> um nível acima por vez;
+    // cada nível só visita as palavras não nulas do mapa de sujeira
+    bitboard_t &base = levels[0].dirty;
+    grid.changed.forEach([&](uint32_t i, uint32_t j) { base.set(i >> VIEW_BASE_SHIFT, j >> VIEW_BASE_SHIFT); });
+    grid.changed.clear();
+    base.forEach([&](uint32_t i, uint32_t j) {
+        countBase(grid, i, j);
+        if (levels.size() > 1)
+            levels[1].dirty.set(i >> 1, j >> 1);
+    });
+    base.clear();
+    for (size_t k = 1; k < levels.size(); k++)
+    {
+        levels[k].dirty.forEach([&](uint32_t i, uint32_t j) {
+            sumChildren(k, i, j);
+            if (k + 1 < levels.size())
+                levels[k + 1].dirty.set(i >> 1, j >> 1);
+        });
+        levels[k].dirty.clear();
+    }
+}
+
+uint32_t view_mipmap_t::maxScale() const
+{
+    return active() ? 1u << levels.back().shift : 0;
+}
+
+void view_mipmap_t::query(const grid_t &grid, uint32_t scale, uint32_t by, uint32_t bx, uint32_t h, uint32_t w,
+                          std::vector<uint32_t> &out) const
+{
+    out.resize((size_t)h * w * VIEW_SPECIES_COUNT);
+    uint32_t *p = out.data();
+    if (scale < (1u << VIEW_BASE_SHIFT))
+    {
+        for (uint32_t i = by; i < by + h; i++)
+            for (uint32_t j = bx; j < bx + w; j++, p += VIEW_SPECIES_COUNT)
+                countCells(grid, i * scale, std::min((i + 1) * scale, grid.rows), j * scale,
+                           std::min((j + 1) * scale, grid.cols), p);
+        return;
+    }
+
+    const level_t &level = levels[__builtin_ctz(scale) - VIEW_BASE_SHIFT];
+    for (uint32_t i = by; i < by + h; i++)
+    {
+        const uint32_t *row = level.block(i, bx);
+        p = std::copy(row, row + (size_t)w * VIEW_SPECIES_COUNT, p);
+    }
+}
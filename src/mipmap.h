@@ -0,0 +1,63 @@
+#pragma once
+
+#include "bitboard.h"
+#include "grid.h"
+#include <cstdint>
+#include <vector>
+
+// Espécies contadas nos blocos, nesta ordem
+const entity_type_t VIEW_SPECIES[] = {plant, herbivore, carnivore};
+const size_t VIEW_SPECIES_COUNT = 3;
+
+// O nível mais fino guardado tem blocos de 2^VIEW_BASE_SHIFT células de
+// lado; a escala 2 é somada direto da grade
+const uint32_t VIEW_BASE_SHIFT = 2;
+
+// Pirâmide de contagens por espécie em blocos de 2^k x 2^k células, para
+// desenhar mundos grandes com custo proporcional à área da tela. Depois de
+// rebuild(), update() só recalcula os blocos com células marcadas em
+// grid.changed (e os ancestrais deles), e limpa as marcas.
+class view_mipmap_t
+{
+public:
+    bool active() const { return !levels.empty(); }
+
+    // Desliga a pirâmide; usado quando a grade é substituída por inteiro
+    void reset() { levels.clear(); }
+
+    // Recalcula todos os níveis a partir da grade
+    void rebuild(grid_t &grid);
+
+    void update(grid_t &grid);
+
+    // Maior escala guardada: um bloco cobre a grade inteira
+    uint32_t maxScale() const;
+
+    // Escreve em `out` (h * w * VIEW_SPECIES_COUNT valores, linha por linha)
+    // as contagens dos blocos de `scale` x `scale` células, potência de 2
+    // entre 2 e maxScale(), a partir do bloco (by, bx). Blocos fora da grade
+    // não devem ser pedidos.
+    void query(const grid_t &grid, uint32_t scale, uint32_t by, uint32_t bx, uint32_t h, uint32_t w,
+               std::vector<uint32_t> &out) const;
+
+private:
+    struct level_t
+    {
+        uint32_t shift;
+        uint32_t rows;
+        uint32_t cols;
+        std::vector<uint32_t> counts; // VIEW_SPECIES_COUNT por bloco
+        bitboard_t dirty;
+
+        uint32_t *block(uint32_t i, uint32_t j) { return counts.data() + ((size_t)i * cols + j) * VIEW_SPECIES_COUNT; }
+        const uint32_t *block(uint32_t i, uint32_t j) const
+        {
+            return counts.data() + ((size_t)i * cols + j) * VIEW_SPECIES_COUNT;
+        }
+    };
+
+    void countBase(const grid_t &grid, uint32_t i, uint32_t j);
+    void sumChildren(size_t k, uint32_t i, uint32_t j);
+
+    std::vector<level_t> levels;
+};
@@ -0,0 +1,158 @@
+#include "params.h"
+#include "rng.h"
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    // Tabela com o nome JSON e o campo de cada parâmetro
+    struct param_field_t
+    {
+        const char *name;
+        int32_t rule_params_t::*int_field;
+        double rule_params_t::*double_field;
+    };
+
+    const param_field_t PARAM_FIELDS[] = {
+        {"plant_maximum_age", &rule_params_t::plant_maximum_age, nullptr},
+        {"plant_reproduction_probability", nullptr, &rule_params_t::plant_reproduction_probability},
+        {"herbivore_maximum_age", &rule_params_t::herbivore_maximum_age, nullptr},
+        {"herbivore_move_probability", nullptr, &rule_params_t::herbivore_move_probability},
+        {"herbivore_eat_probability", nullptr, &rule_params_t::herbivore_eat_probability},
+        {"herbivore_reproduction_probability", nullptr, &rule_params_t::herbivore_reproduction_probability},
+        {"herbivore_eat_energy_gain", &rule_params_t::herbivore_eat_energy_gain, nullptr},
+        {"carnivore_maximum_age", &rule_params_t::carnivore_maximum_age, nullptr},
+        {"carnivore_move_probability", nullptr, &rule_params_t::carnivore_move_probability},
+        {"carnivore_eat_probability", nullptr, &rule_params_t::carnivore_eat_probability},
+        {"carnivore_reproduction_probability", nullptr, &rule_params_t::carnivore_reproduction_probability},
+        {"carnivore_eat_energy_gain", &rule_params_t::carnivore_eat_energy_gain, nullptr},
+        {"maximum_energy", &rule_params_t::maximum_energy, nullptr},
+        {"initial_energy", &rule_params_t::initial_energy, nullptr},
+        {"threshold_energy_for_reproduction", &rule_params_t::threshold_energy_for_reproduction, nullptr},
+        {"move_energy_cost", &rule_params_t::move_energy_cost, nullptr},
+        {"reproduction_energy_cost", &rule_params_t::reproduction_energy_cost, nullptr},
+    };
+
+    const param_field_t *findField(const std::string &name)
+    {
+        for (const param_field_t &f : PARAM_FIELDS)
+            if (name == f.name)
+                return &f;
+        return nullptr;
+    }
+
+    species_rules_t compileSpecies(const rule_params_t &p, int32_t maximum_age, double move, double eat,
+                                   double reproduction, int32_t eat_energy_gain)
+    {
+        return {probabilityThreshold(move),
+                probabilityThreshold(eat),
+                probabilityThreshold(reproduction),
+                maximum_age,
+                eat_energy_gain,
+                p.move_energy_cost,
+                p.reproduction_energy_cost,
+                p.threshold_energy_for_reproduction,
+                p.maximum_energy};
+    }
+}
+
+void validateParams(const rule_params_t &params)
+{
+    for (const param_field_t &f : PARAM_FIELDS)
+    {
+        if (f.double_field)
+        {
+            double v = params.*f.double_field;
+            if (!(v >= 0.0 && v <= 1.0))
+                throw std::invalid_argument(std::string(f.name) + " must be between 0 and 1");
+        }
+        else if (params.*f.int_field < 0 || params.*f.int_field > MAX_INTEGER_PARAM)
+        {
+            throw std::invalid_argument(std::string(f.name) + " must be between 0 and " +
+                                        std::to_string(MAX_INTEGER_PARAM));
+        }
+    }
+    if (params.plant_maximum_age < 1 || params.herbivore_maximum_age < 1 || params.carnivore_maximum_age < 1)
+        throw std::invalid_argument("maximum ages must be at least 1");
+    if (params.initial_energy < 1 || params.initial_energy > params.maximum_energy)
+        throw std::invalid_argument("initial_energy must be between 1 and maximum_energy");
+}
+
+compiled_rules_t compileRules(const rule_params_t &params)
+{
+    compiled_rules_t rules{};
+    rules.plant = {params.plant_maximum_age, probabilityThreshold(params.plant_reproduction_probability)};
+    rules.animals[herbivore] = compileSpecies(params, params.herbivore_maximum_age, params.herbivore_move_probability,
+                                              params.herbivore_eat_probability, params.herbivore_reproduction_probability,
+                                              params.herbivore_eat_energy_gain);
+    rules.animals[carnivore] = compileSpecies(params, params.carnivore_maximum_age, params.carnivore_move_probability,
+                                              params.carnivore_eat_probability, params.carnivore_reproduction_probability,
+                                              params.carnivore_eat_energy_gain);
+    rules.initial_energy = params.initial_energy;
+    return rules;
+}
+
+void mergeParams(rule_params_t &params, const nlohmann::json &j)
+{
+    if (!j.is_object())
+        throw std::invalid_argument("parameters must be a JSON object");
+
+    rule_params_t merged = params;
+    for (auto it = j.begin(); it != j.end(); ++it)
+    {
+        const param_field_t *f = findField(it.key());
+        if (f == nullptr)
+            throw std::invalid_argument("unknown parameter " + it.key());
+        if (!it.value().is_number())
+            throw std::invalid_argument(it.key() + " must be a number");
+        if (f->double_field)
+        {
+            merged.*f->double_field = it.value().get<double>();
+            continue;
+        }
+        // get<int32_t>() truncaria 2.9 para 2 e daria a volta em valores
+        // grandes; o intervalo em si é conferido por validateParams()
+        const nlohmann::json &v = it.value();
+        if (!v.is_number_integer())
+            throw std::invalid_argument(it.key() + " must be an integer");
+        if (v.is_number_unsigned() ? v.get<uint64_t>() > (uint64_t)MAX_INTEGER_PARAM
+                                   : v.get<int64_t>() < 0 || v.get<int64_t>() > MAX_INTEGER_PARAM)
+            throw std::invalid_argument(it.key() + " must be between 0 and " + std::to_string(MAX_INTEGER_PARAM));
+        merged.*f->int_field = (int32_t)v.get<int64_t>();
+    }
+    validateParams(merged);
+    params = merged;
+}
+
+rule_params_t loadParamsFile(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::invalid_argument("cannot open parameter file " + path);
+
+    rule_params_t params;
+    nlohmann::json j;
+    try
+    {
+        in >> j;
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+        throw std::invalid_argument(path + ": " + e.what());
+    }
+    mergeParams(params, j);
+    return params;
+}
+
+nlohmann::json paramsToJson(const rule_params_t &params)
+{
+    nlohmann::json j = nlohmann::json::object();
+    for (const param_field_t &f : PARAM_FIELDS)
+    {
+        if (f.double_field)
+            j[f.name] = params.*f.double_field;
+        else
+            j[f.name] = params.*f.int_field;
+    }
+    return j;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "grid.h"
+#include "json.hpp"
+#include "plant_kernel.h"
+#include "species.h"
+#include <cstdint>
+#include <string>
+
+// Parâmetros das regras como o usuário os escreve (probabilidades em [0, 1]).
+// Os valores padrão são as constantes de species.h. Em JSON cada campo usa o
+// mesmo nome, ex.: {"herbivore_move_probability": 0.8}; campos ausentes
+// mantêm o valor atual.
+struct rule_params_t
+{
+    int32_t plant_maximum_age = PLANT_MAXIMUM_AGE;
+    double plant_reproduction_probability = PLANT_REPRODUCTION_PROBABILITY;
+
+    int32_t herbivore_maximum_age = HERBIVORE_MAXIMUM_AGE;
+    double herbivore_move_probability = HERBIVORE_MOVE_PROBABILITY;
+    double herbivore_eat_probability = HERBIVORE_EAT_PROBABILITY;
+    double herbivore_reproduction_probability = HERBIVORE_REPRODUCTION_PROBABILITY;
+    int32_t herbivore_eat_energy_gain = HERBIVORE_EAT_ENERGY_GAIN;
+
+    int32_t carnivore_maximum_age = CARNIVORE_MAXIMUM_AGE;
+    double carnivore_move_probability = CARNIVORE_MOVE_PROBABILITY;
+    double carnivore_eat_probability = CARNIVORE_EAT_PROBABILITY;
+    double carnivore_reproduction_probability = CARNIVORE_REPRODUCTION_PROBABILITY;
+    int32_t carnivore_eat_energy_gain = CARNIVORE_EAT_ENERGY_GAIN;
+
+    int32_t maximum_energy = MAXIMUM_ENERGY;
+    int32_t initial_energy = INITIAL_ENERGY;
+    int32_t threshold_energy_for_reproduction = THRESHOLD_ENERGY_FOR_REPRODUCTION;
+    int32_t move_energy_cost = MOVE_ENERGY_COST;
+    int32_t reproduction_energy_cost = REPRODUCTION_ENERGY_COST;
+};
+
+// Regras de uma espécie animal já no formato do kernel: probabilidades
+// convertidas em limiares inteiros (ver probabilityThreshold())
+struct species_rules_t
+{
+    uint32_t move_threshold;
+    uint32_t eat_threshold;
+    uint32_t reproduction_threshold;
+    int32_t maximum_age;
+    int32_t eat_energy_gain;
+    int32_t move_energy_cost;
+    int32_t reproduction_energy_cost;
+    int32_t reproduction_energy_threshold;
+    int32_t maximum_energy;
+};
+
+// Conjunto de regras pré-calculado a partir de um rule_params_t. É trocado
+// inteiro entre iterações, então o laço principal nunca vê probabilidades em
+// ponto flutuante nem um conjunto pela metade.
+struct compiled_rules_t
+{
+    plant_rules_t plant;
+    species_rules_t animals[ENTITY_TYPE_COUNT]; // indexado por entity_type_t
+    int32_t initial_energy;
+};
+
+// Maior valor dos parâmetros inteiros (idades, energias, ganhos e custos).
+// Com energias e ganhos até 2^29, somas como energia + ganho e as
+// subtrações dos custos nunca estouram int32 nos kernels.
+const int32_t MAX_INTEGER_PARAM = 1 << 29;
+
+// Lança std::invalid_argument se algum valor estiver fora do intervalo válido
+void validateParams(const rule_params_t &params);
+
+compiled_rules_t compileRules(const rule_params_t &params);
+
+// Aplica sobre `params` os campos presentes no objeto JSON; lança
+// std::invalid_argument para campos desconhecidos ou valores inválidos
+// (inclusive números não inteiros nos campos inteiros)
+void mergeParams(rule_params_t &params, const nlohmann::json &j);
+
+// Lê um arquivo JSON de parâmetros sobre os valores padrão
+rule_params_t loadParamsFile(const std::string &path);
+
+nlohmann::json paramsToJson(const rule_params_t &params);
@@ -0,0 +1,148 @@
+#include "placement.h"
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    // Abaixo desta fração de células sorteadas o embaralhamento guarda só as
+    // posições trocadas, em vez de um vetor com todas as células vazias
+    const double SPARSE_SHUFFLE_FRACTION = 0.05;
+
+    // Fisher–Yates parcial sobre as posições 0 .. count - 1: a cada passo
+    // sorteia uma das posições ainda não usadas e a troca com a posição `k`.
+    // Cada posição sai no máximo uma vez, então o custo é O(sorteios) mesmo
+    // com a grade inteira preenchida.
+    template <typename Index>
+    class partial_shuffle_t
+    {
+    public:
+        // `reserve`: número esperado de sorteios no modo esparso
+        partial_shuffle_t(size_t count, bool sparse, size_t reserve = 0) : count(count), sparse(sparse)
+        {
+            if (!sparse)
+            {
+                dense.resize(count);
+                for (size_t k = 0; k < count; k++)
+                    dense[k] = (Index)k;
+            }
+            else
+            {
+                swapped.reserve(2 * reserve);
+            }
+        }
+
+        size_t next(std::mt19937_64 &rng)
+        {
+            size_t pick = std::uniform_int_distribution<size_t>(k, count - 1)(rng);
+            size_t value;
+            if (sparse)
+            {
+                value = get(pick);
+                swapped[pick] = get(k);
+            }
+            else
+            {
+                value = dense[pick];
+                dense[pick] = (Index)dense[k];
+            }
+            k++;
+            return value;
+        }
+
+    private:
+        size_t get(size_t position) const
+        {
+            auto it = swapped.find(position);
+            return it == swapped.end() ? position : it->second;
+        }
+
+        size_t count;
+        size_t k = 0;
+        bool sparse;
+        std::vector<Index> dense;
+        std::unordered_map<size_t, size_t> swapped;
+    };
+
+    // Sorteia `total` posições distintas em 0 .. count - 1 e chama fn(posição)
+    // para cada uma. Índices de 32 bits quando cabem: metade da memória
+    // percorrida aleatoriamente no modo denso.
+    template <typename Fn>
+    void drawDistinct(size_t count, size_t total, bool sparse, std::mt19937_64 &rng, Fn &&fn)
+    {
+        if (count <= UINT32_MAX)
+        {
+            partial_shuffle_t<uint32_t> shuffle(count, sparse, total);
+            for (size_t n = 0; n < total; n++)
+                fn(shuffle.next(rng));
+        }
+        else
+        {
+            partial_shuffle_t<size_t> shuffle(count, sparse, total);
+            for (size_t n = 0; n < total; n++)
+                fn(shuffle.next(rng));
+        }
+    }
+}
+
+void placeEntities(world_t &world, uint32_t plants, uint32_t herbivores, uint32_t carnivores)
+{
+    grid_t &grid = world.grid;
+    const size_t total = (size_t)plants + herbivores + carnivores;
+
+    // Células candidatas: a grade inteira se estiver vazia (o caso comum,
+    // logo depois de reset()), senão só as vazias
+    std::vector<size_t> empty_cells;
+    size_t candidates = grid.size();
+    if (grid.population(empty) != grid.size())
+    {
+        grid.occupancy[empty].forEach([&](uint32_t i, uint32_t j) { empty_cells.push_back(grid.index(i, j)); });
+        candidates = empty_cells.size();
+    }
+    if (total > candidates)
+        throw std::invalid_argument("Too many entities");
+    if (total == 0)
+        return;
+
+    const entity_t entities[3] = {{plant, 0, 0},
+                                  {carnivore, world.rules.initial_energy, 0},
+                                  {herbivore, world.rules.initial_energy, 0}};
+    const uint32_t counts[3] = {plants, carnivores, herbivores};
+    const bool sparse = total < candidates * SPARSE_SHUFFLE_FRACTION;
+
+    // Poucas entidades: escreve direto na grade. Muitas: marca o tipo de
+    // cada célula sorteada e preenche a grade em uma passada sequencial,
+    // em vez de escritas espalhadas pelas colunas e mapas de ocupação
+    std::vector<uint8_t> chosen(sparse ? 0 : grid.size(), empty);
+    std::mt19937_64 rng(world.seed);
+    size_t e = 0, placed = 0; // entidades na ordem: plantas, carnívoros, herbívoros
+    drawDistinct(candidates, total, sparse, rng, [&](size_t cell) {
+        while (placed == counts[e])
+        {
+            e++;
+            placed = 0;
+        }
+        placed++;
+        if (!empty_cells.empty())
+            cell = empty_cells[cell];
+        if (sparse)
+            grid.at((uint32_t)(cell / grid.cols), (uint32_t)(cell % grid.cols)) = entities[e];
+        else
+            chosen[cell] = (uint8_t)entities[e].type;
+    });
+    if (sparse)
+        return;
+
+    for (size_t cell = 0; cell < grid.size(); cell++)
+    {
+        if (chosen[cell] == empty)
+            continue;
+        const entity_t &entity = chosen[cell] == plant ? entities[0] : entities[chosen[cell] == carnivore ? 1 : 2];
+        grid.type[cell] = (uint8_t)entity.type;
+        grid.energy[cell] = entity.energy;
+        grid.age[cell] = entity.age;
+    }
+    grid.rebuildOccupancy();
+}
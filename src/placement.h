@@ -0,0 +1,11 @@
+#pragma once
+
+#include "world.h"
+#include <cstdint>
+
+// Coloca as entidades iniciais em células vazias sorteadas a partir da
+// semente do mundo: plantas com idade 0, animais com a energia inicial das
+// regras em vigor. As células saem de um embaralhamento parcial, então o
+// custo é linear mesmo com a grade cheia. Lança std::invalid_argument se o
+// total não couber nas células vazias.
+void placeEntities(world_t &world, uint32_t plants, uint32_t herbivores, uint32_t carnivores);
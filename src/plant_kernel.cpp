@@ -0,0 +1,343 @@
+#include "plant_kernel.h"
+#include "rng.h"
+#include <cstdlib>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ECOSIM_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // A direção de reprodução indexa os deslocamentos da vizinhança (na de
+    // von Neumann, 0: baixo, 1: direita, 2: esquerda, 3: cima)
+    struct plant_keys_t
+    {
+        uint32_t reproduction;
+        uint32_t direction;
+    };
+
+    // Posição de (i, j) em `seeded`, que tem uma borda de uma célula em volta
+    // da grade (i e j vão de -1 a rows e cols)
+    inline size_t seededIndex(const grid_t &grid, int64_t i, int64_t j)
+    {
+        return (size_t)(i + 1) * (grid.cols + 2) + (size_t)(j + 1);
+    }
+
+    // Primeira passada, escalar: marca em `seeded` a célula onde a planta vai
+    // gerar uma nova planta, se houver. A marca vai para a posição do vizinho
+    // sem aplicar o contorno, possivelmente na borda (ver foldSeededHalo()).
+    template <typename N>
+    inline void markCellScalar(const grid_t &grid, uint8_t *seeded, const plant_rules_t &rules,
+                               const plant_keys_t &keys, uint32_t i, uint32_t j)
+    {
+        size_t idx = grid.index(i, j);
+        if (grid.type[idx] != plant || grid.age[idx] >= rules.maximum_age)
+            return;
+        if (!drawProbability(cellRandom(keys.reproduction, (uint32_t)idx), rules.reproduction_threshold))
+            return;
+
+        // O mapa de células vazias tem bordas, então não há teste de limites
+        const uint32_t d = cellRandom(keys.direction, (uint32_t)idx) % N::count;
+        const offset_t o = N::at(i)[d];
+        const int64_t ti = (int64_t)i + o.di;
+        const int64_t tj = (int64_t)j + o.dj;
+        if (grid.occupancy[empty].test(ti, tj))
+            seeded[seededIndex(grid, ti, tj)] = 0xFF;
+    }
+
+    // Leva as marcas feitas na borda de `seeded` para a célula da grade que
+    // ela repete e limpa a borda. Uma célula da borda só é marcada se o mapa
+    // de vazias diz que ela está vazia, o que no contorno clip nunca acontece.
+    template <typename B>
+    void foldSeededHalo(const grid_t &grid, uint8_t *seeded)
+    {
+        if constexpr (B::id != BOUNDARY_CLIP)
+        {
+            auto fold = [&](int64_t i, int64_t j) {
+                uint8_t &mark = seeded[seededIndex(grid, i, j)];
+                if (!mark)
+                    return;
+                mark = 0;
+                seeded[seededIndex(grid, B::wrap(i, grid.rows), B::wrap(j, grid.cols))] = 0xFF;
+            };
+            for (int64_t j = -1; j <= (int64_t)grid.cols; j++)
+            {
+                fold(-1, j);
+                fold(grid.rows, j);
+            }
+            for (uint32_t i = 0; i < grid.rows; i++)
+            {
+                fold(i, -1);
+                fold(i, grid.cols);
+            }
+        }
+    }
+
+    // Segunda passada, escalar: envelhece ou remove a planta e cria as
+    // plantas marcadas na primeira passada
+    inline void updateCellScalar(grid_t &grid, uint8_t &seeded, const plant_rules_t &rules, size_t idx)
+    {
+        uint8_t type = grid.type[idx];
+        if (type == plant)
+        {
+            if (grid.age[idx] >= rules.maximum_age)
+            {
+                grid.type[idx] = empty;
+                grid.age[idx] = 0;
+                grid.energy[idx] = 0;
+            }
+            else
+            {
+                grid.age[idx]++;
+            }
+        }
+        else if (type == empty && seeded)
+        {
+            grid.type[idx] = plant;
+            grid.age[idx] = 0;
+            grid.energy[idx] = 0;
+        }
+        seeded = 0;
+    }
+
+    template <typename N, typename B>
+    void simulatePlantsScalar(grid_t &grid, uint8_t *seeded, const plant_rules_t &rules, const plant_keys_t &keys)
+    {
+        for (uint32_t i = 0; i < grid.rows; i++)
+            for (uint32_t j = 0; j < grid.cols; j++)
+                markCellScalar<N>(grid, seeded, rules, keys, i, j);
+        foldSeededHalo<B>(grid, seeded);
+
+        for (uint32_t i = 0; i < grid.rows; i++)
+            for (uint32_t j = 0; j < grid.cols; j++)
+                updateCellScalar(grid, seeded[seededIndex(grid, i, j)], rules, grid.index(i, j));
+    }
+
+#ifdef ECOSIM_HAVE_AVX2
+#define ECOSIM_AVX2 __attribute__((target("avx2")))
+
+    ECOSIM_AVX2 inline __m256i load8Types(const uint8_t *p)
+    {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)p));
+    }
+
+    // Converte 8 máscaras de 32 bits (0 ou -1) em 8 bytes (0 ou 0xFF)
+    ECOSIM_AVX2 inline __m128i packMask8(__m256i m)
+    {
+        __m256i p16 = _mm256_packs_epi32(m, m);
+        p16 = _mm256_permute4x64_epi64(p16, 0x08);
+        __m128i m16 = _mm256_castsi256_si128(p16);
+        return _mm_packs_epi16(m16, m16);
+    }
+
+    ECOSIM_AVX2 inline __m256i mixRandom8(__m256i x)
+    {
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x7feb352dU));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+        x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x846ca68bU));
+        x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        return x;
+    }
+
+    ECOSIM_AVX2 inline __m256i cellRandom8(uint32_t key, __m256i cells)
+    {
+        __m256i x = _mm256_mullo_epi32(cells, _mm256_set1_epi32((int)CELL_RANDOM_MULTIPLIER));
+        return mixRandom8(_mm256_add_epi32(x, _mm256_set1_epi32((int)key)));
+    }
+
+    // Equivalente vetorial de drawProbability(): (sorteio >> 1) <= limiar - 1
+    ECOSIM_AVX2 inline __m256i drawProbability8(__m256i random, uint32_t threshold)
+    {
+        __m256i limit = _mm256_set1_epi32((int32_t)(threshold - 1));
+        __m256i above = _mm256_cmpgt_epi32(_mm256_srli_epi32(random, 1), limit);
+        return _mm256_xor_si256(above, _mm256_set1_epi32(-1));
+    }
+
+    ECOSIM_AVX2 inline void orSeeded8(uint8_t *p, __m256i mask)
+    {
+        __m128i s = _mm_loadl_epi64((const __m128i *)p);
+        _mm_storel_epi64((__m128i *)p, _mm_or_si128(s, packMask8(mask)));
+    }
+
+    // 8 máscaras (0 ou -1), uma por bit dos 8 bits baixos de `bits`
+    ECOSIM_AVX2 inline __m256i expandBits8(uint64_t bits)
+    {
+        const __m256i lane_bit = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        __m256i m = _mm256_and_si256(_mm256_set1_epi32((int)(bits & 0xFF)), lane_bit);
+        return _mm256_cmpeq_epi32(m, lane_bit);
+    }
+
+    // Primeira passada de uma linha: 8 plantas por vez. Os vizinhos vazios
+    // vêm do mapa de ocupação, lido a partir da coluna deslocada nas linhas
+    // de cima, de baixo e na própria; como as bordas dele fazem o papel das
+    // células além da grade, a primeira e a última linha e coluna não têm
+    // caso especial. Só a vizinhança de von Neumann tem caminho vetorial.
+    ECOSIM_AVX2 void markRowAvx2(const grid_t &grid, uint8_t *seeded, const plant_rules_t &rules,
+                                 const plant_keys_t &keys, uint32_t i)
+    {
+        const __m256i plant_v = _mm256_set1_epi32(plant);
+        const __m256i max_age = _mm256_set1_epi32(rules.maximum_age - 1);
+        const __m256i three = _mm256_set1_epi32(3);
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const bitboard_t &vacant = grid.occupancy[empty];
+        const uint64_t *vacant_up = vacant.row((int64_t)i - 1);
+        const uint64_t *vacant_row = vacant.row(i);
+        const uint64_t *vacant_down = vacant.row((int64_t)i + 1);
+        const size_t stride = grid.cols + 2;
+        const uint32_t cols = grid.cols;
+        const uint8_t *type = grid.type.data();
+        const int32_t *ages = grid.age.data();
+        uint8_t *seeded_row = seeded + seededIndex(grid, i, 0);
+        const size_t row_base = grid.index(i, 0);
+
+        uint32_t j = 0;
+        for (; j + 8 <= cols; j += 8)
+        {
+            size_t base = row_base + j;
+            __m256i t = load8Types(type + base);
+            __m256i age = _mm256_loadu_si256((const __m256i *)(ages + base));
+            __m256i alive = _mm256_andnot_si256(_mm256_cmpgt_epi32(age, max_age), _mm256_cmpeq_epi32(t, plant_v));
+            if (_mm256_testz_si256(alive, alive))
+                continue;
+
+            __m256i cells = _mm256_add_epi32(_mm256_set1_epi32((int)base), lane);
+            __m256i spread = _mm256_and_si256(alive, drawProbability8(cellRandom8(keys.reproduction, cells),
+                                                                      rules.reproduction_threshold));
+            if (_mm256_testz_si256(spread, spread))
+                continue;
+            __m256i dir = _mm256_and_si256(cellRandom8(keys.direction, cells), three);
+
+            __m256i down = _mm256_and_si256(_mm256_cmpeq_epi32(dir, _mm256_setzero_si256()),
+                                            expandBits8(bitboard_t::bitsAt(vacant_down, j)));
+            __m256i right = _mm256_and_si256(_mm256_cmpeq_epi32(dir, _mm256_set1_epi32(1)),
+                                             expandBits8(bitboard_t::bitsAt(vacant_row, (int64_t)j + 1)));
+            __m256i left = _mm256_and_si256(_mm256_cmpeq_epi32(dir, _mm256_set1_epi32(2)),
+                                            expandBits8(bitboard_t::bitsAt(vacant_row, (int64_t)j - 1)));
+            __m256i up = _mm256_and_si256(_mm256_cmpeq_epi32(dir, three),
+                                          expandBits8(bitboard_t::bitsAt(vacant_up, j)));
+
+            uint8_t *s = seeded_row + j;
+            orSeeded8(s + stride, _mm256_and_si256(spread, down));
+            orSeeded8(s + 1, _mm256_and_si256(spread, right));
+            orSeeded8(s - 1, _mm256_and_si256(spread, left));
+            orSeeded8(s - stride, _mm256_and_si256(spread, up));
+        }
+        for (; j < grid.cols; j++)
+            markCellScalar<von_neumann_t>(grid, seeded, rules, keys, i, j);
+    }
+
+    // Segunda passada: as células são independentes, então cada linha é
+    // percorrida como um único array
+    ECOSIM_AVX2 void updateCellsAvx2(grid_t &grid, uint8_t *seeded, const plant_rules_t &rules)
+    {
+        const __m256i plant_v = _mm256_set1_epi32(plant);
+        const __m256i empty_v = _mm256_set1_epi32(empty);
+        const __m256i max_age = _mm256_set1_epi32(rules.maximum_age - 1);
+        const __m256i one = _mm256_set1_epi32(1);
+
+        for (uint32_t i = 0; i < grid.rows; i++)
+        {
+            const size_t base = grid.index(i, 0);
+            uint8_t *seeded_row = seeded + seededIndex(grid, i, 0);
+            uint32_t j = 0;
+            for (; j + 8 <= grid.cols; j += 8)
+            {
+                const size_t k = base + j;
+                uint8_t *type_p = grid.type.data() + k;
+                __m256i *age_p = (__m256i *)(grid.age.data() + k);
+                __m256i *energy_p = (__m256i *)(grid.energy.data() + k);
+
+                __m256i t = load8Types(type_p);
+                __m256i s = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)(seeded_row + j)));
+                __m256i is_plant = _mm256_cmpeq_epi32(t, plant_v);
+                __m256i born = _mm256_and_si256(s, _mm256_cmpeq_epi32(t, empty_v));
+                if (_mm256_testz_si256(_mm256_or_si256(is_plant, born), _mm256_set1_epi32(-1)))
+                    continue;
+
+                __m256i age = _mm256_loadu_si256(age_p);
+                __m256i dead = _mm256_and_si256(is_plant, _mm256_cmpgt_epi32(age, max_age));
+                __m256i reset = _mm256_or_si256(dead, born);
+
+                age = _mm256_add_epi32(age, _mm256_and_si256(is_plant, one));
+                _mm256_storeu_si256(age_p, _mm256_andnot_si256(reset, age));
+                _mm256_storeu_si256(energy_p, _mm256_andnot_si256(reset, _mm256_loadu_si256(energy_p)));
+
+                t = _mm256_or_si256(_mm256_andnot_si256(dead, t), _mm256_and_si256(born, plant_v));
+                __m256i t16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(t, t), 0x08);
+                __m128i t8 = _mm_packus_epi16(_mm256_castsi256_si128(t16), _mm256_castsi256_si128(t16));
+                _mm_storel_epi64((__m128i *)type_p, t8);
+                _mm_storel_epi64((__m128i *)(seeded_row + j), _mm_setzero_si128());
+            }
+            for (; j < grid.cols; j++)
+                updateCellScalar(grid, seeded_row[j], rules, base + j);
+        }
+    }
+
+    template <typename B>
+    ECOSIM_AVX2 void simulatePlantsAvx2(grid_t &grid, uint8_t *seeded, const plant_rules_t &rules, const plant_keys_t &keys)
+    {
+        for (uint32_t i = 0; i < grid.rows; i++)
+            markRowAvx2(grid, seeded, rules, keys, i);
+        foldSeededHalo<B>(grid, seeded);
+        updateCellsAvx2(grid, seeded, rules);
+    }
+#endif
+
+    struct plant_kernel_t
+    {
+        bool avx2;
+        const char *name;
+    };
+
+    // Escolhe o kernel uma única vez; ECOSIM_NO_SIMD força o caminho escalar
+    plant_kernel_t selectPlantKernel()
+    {
+#ifdef ECOSIM_HAVE_AVX2
+        if (std::getenv("ECOSIM_NO_SIMD") == nullptr && __builtin_cpu_supports("avx2"))
+            return {true, "avx2"};
+#endif
+        return {false, "scalar"};
+    }
+
+    const plant_kernel_t &plantKernel()
+    {
+        static const plant_kernel_t kernel = selectPlantKernel();
+        return kernel;
+    }
+}
+
+void simulatePlants(grid_t &grid, std::vector<uint8_t> &seeded, const plant_rules_t &rules,
+                    uint64_t seed, uint64_t tick)
+{
+    // `seeded` tem uma borda de uma célula em volta da grade
+    const size_t seeded_size = (size_t)(grid.rows + 2) * (grid.cols + 2);
+    if (seeded.size() != seeded_size)
+        seeded.assign(seeded_size, 0);
+
+    plant_keys_t keys{streamKey(seed, tick, STREAM_PLANT_REPRODUCTION),
+                      streamKey(seed, tick, STREAM_PLANT_DIRECTION)};
+    dispatchTopology(grid.topology, [&](auto neighbourhood, auto boundary) {
+        using N = decltype(neighbourhood);
+        using B = decltype(boundary);
+#ifdef ECOSIM_HAVE_AVX2
+        if constexpr (std::is_same_v<N, von_neumann_t>)
+        {
+            if (plantKernel().avx2)
+            {
+                simulatePlantsAvx2<B>(grid, seeded.data(), rules, keys);
+                return;
+            }
+        }
+#endif
+        simulatePlantsScalar<N, B>(grid, seeded.data(), rules, keys);
+    });
+    grid.rebuildOccupancy();
+}
+
+const char *plantKernelName()
+{
+    return plantKernel().name;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "grid.h"
+#include <cstdint>
+#include <vector>
+
+// Regras das plantas já convertidas para o formato usado pelo kernel
+struct plant_rules_t
+{
+    int32_t maximum_age;
+    uint32_t reproduction_threshold; // ver probabilityThreshold()
+};
+
+// Executa a fase das plantas de uma iteração sobre a grade inteira:
+// envelhecimento, morte ao atingir a idade máxima e reprodução para uma
+// célula vizinha vazia, segundo a topologia da grade. As decisões são
+// tomadas sobre o estado do início da fase; `seeded` é memória de rascunho
+// reutilizada entre iterações, com uma borda de uma célula em volta da grade
+// para que as marcas nos vizinhos nunca testem limites. Na vizinhança de von
+// Neumann usa AVX2 quando o processador suporta, com resultado idêntico ao
+// escalar.
+void simulatePlants(grid_t &grid, std::vector<uint8_t> &seeded, const plant_rules_t &rules,
+                    uint64_t seed, uint64_t tick);
+
+// Nome do caminho escolhido em tempo de execução ("avx2" ou "scalar")
+const char *plantKernelName();
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+// Gerador aleatório baseado em contador: cada sorteio é um hash de
+// (semente, iteração, fluxo, célula). Não há estado compartilhado entre
+// threads e o mesmo sorteio pode ser calculado 8 células por vez em AVX2,
+// dando exatamente o mesmo resultado que o caminho escalar.
+
+// Fluxos de sorteio independentes usados pelos kernels
+enum rng_stream_t : uint32_t
+{
+    STREAM_PLANT_REPRODUCTION,
+    STREAM_PLANT_DIRECTION,
+    STREAM_MOVE,
+    STREAM_MOVE_DIRECTION,
+    STREAM_EAT,
+    STREAM_EAT_DIRECTION,
+    STREAM_REPRODUCTION,
+    STREAM_REPRODUCTION_DIRECTION,
+    STREAM_DENSITY_PLACEMENT, // inicialização por mapas de densidade
+    STREAM_DENSITY_NOISE,
+    STREAM_MOVE_PRIORITY, // desempate entre animais que pedem a mesma célula
+};
+
+inline uint32_t mixRandom(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// Chave de um fluxo para uma iteração; calculada uma vez por fase
+inline uint32_t streamKey(uint64_t seed, uint64_t tick, uint32_t stream)
+{
+    uint32_t k = mixRandom((uint32_t)seed ^ 0x9e3779b9U);
+    k = mixRandom(k ^ (uint32_t)(seed >> 32));
+    k = mixRandom(k ^ (uint32_t)tick);
+    k = mixRandom(k ^ (uint32_t)(tick >> 32));
+    return mixRandom(k + stream * 0x85ebca6bU);
+}
+
+const uint32_t CELL_RANDOM_MULTIPLIER = 0x9e3779b9U;
+
+inline uint32_t cellRandom(uint32_t key, uint32_t cell)
+{
+    return mixRandom(cell * CELL_RANDOM_MULTIPLIER + key);
+}
+
+// Converte uma probabilidade em um limiar inteiro de 31 bits: o evento
+// acontece quando (sorteio >> 1) < limiar
+constexpr uint32_t probabilityThreshold(double prob)
+{
+    return prob <= 0.0 ? 0u : prob >= 1.0 ? 0x80000000u : (uint32_t)(prob * 2147483648.0);
+}
+
+inline bool drawProbability(uint32_t random, uint32_t threshold)
+{
+    return (random >> 1) < threshold;
+}
@@ -0,0 +1,275 @@
+#include "serialize.h"
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+namespace nlohmann
+{
+    void to_json(nlohmann::json &j, const entity_t &e)
+    {
+        j = nlohmann::json{{"type", e.type}, {"energy", e.energy}, {"age", e.age}};
+    }
+
+    void to_json(nlohmann::json &j, const grid_t &g)
+    {
+        j = nlohmann::json::array();
+        for (uint32_t i = 0; i < g.rows; i++)
+        {
+            nlohmann::json row = nlohmann::json::array();
+            for (uint32_t k = 0; k < g.cols; k++)
+                row.push_back(g.get(i, k));
+            j.push_back(std::move(row));
+        }
+    }
+}
+
+namespace
+{
+    // Escrita sequencial de texto em um buffer fixo, despejado no fim de
+    // `out` quando enche; nenhuma alocação além do crescimento de `out`
+    class text_stream_t
+    {
+    public:
+        explicit text_stream_t(std::string &out) : out(out) {}
+        ~text_stream_t() { flush(); }
+
+        void put(char c)
+        {
+            ensure(1);
+            buffer[length++] = c;
+        }
+
+        void put(const char *text, size_t n)
+        {
+            ensure(n);
+            std::memcpy(buffer + length, text, n);
+            length += n;
+        }
+
+        void put(const std::string &text) { put(text.data(), text.size()); }
+
+        template <size_t N>
+        void put(const char (&literal)[N])
+        {
+            ensure(N - 1);
+            std::memcpy(buffer + length, literal, N - 1);
+            length += N - 1;
+        }
+
+        void putInt(int32_t value)
+        {
+            ensure(11);
+            length = (size_t)(std::to_chars(buffer + length, buffer + sizeof(buffer), value).ptr - buffer);
+        }
+
+    private:
+        // Textos maiores que o buffer não são escritos por aqui
+        void ensure(size_t n)
+        {
+            if (length + n > sizeof(buffer))
+                flush();
+        }
+
+        void flush()
+        {
+            out.append(buffer, length);
+            length = 0;
+        }
+
+        std::string &out;
+        char buffer[16 * 1024];
+        size_t length = 0;
+    };
+
+    // Texto de cada valor de type: o símbolo (já escapado para JSON, sem as
+    // aspas), o final do objeto da célula, ex.: `,"type":"P"}`, e o objeto
+    // inteiro quando type é a única chave, ex.: `{"type":"P"}`. Os símbolos
+    // vêm de NLOHMANN_JSON_SERIALIZE_ENUM, então o texto é o mesmo do
+    // serializador do nlohmann (valores desconhecidos viram o primeiro
+    // símbolo da lista)
+    struct type_text_t
+    {
+        std::array<std::string, 256> symbol;
+        std::array<std::string, 256> suffix;
+        std::array<std::string, 256> alone;
+    };
+
+    const type_text_t &typeText()
+    {
+        static const type_text_t text = [] {
+            type_text_t table;
+            for (size_t t = 0; t < 256; t++)
+            {
+                const std::string quoted = nlohmann::json((entity_type_t)t).dump();
+                table.symbol[t] = quoted.substr(1, quoted.size() - 2);
+                table.suffix[t] = ",\"type\":" + quoted + "}";
+                table.alone[t] = "{\"type\":" + quoted + "}";
+            }
+            return table;
+        }();
+        return text;
+    }
+
+    // Colunas numéricas do formato compacto: um array por linha
+    void putRows(text_stream_t &stream, const grid_t &grid, const column_t<int32_t> &column)
+    {
+        stream.put('[');
+        for (uint32_t i = 0; i < grid.rows; i++)
+        {
+            if (i > 0)
+                stream.put(',');
+            stream.put('[');
+            for (uint32_t j = 0; j < grid.cols; j++)
+            {
+                if (j > 0)
+                    stream.put(',');
+                stream.putInt(column[grid.index(i, j)]);
+            }
+            stream.put(']');
+        }
+        stream.put(']');
+    }
+}
+
+uint32_t parseGridFields(const std::string &list)
+{
+    uint32_t fields = 0;
+    // getline() descartaria o nome vazio depois de uma vírgula final; aqui
+    // todo trecho entre vírgulas (ou nas pontas) conta, e vazio é erro
+    size_t start = 0;
+    while (start <= list.size())
+    {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos)
+            end = list.size();
+        const std::string name = list.substr(start, end - start);
+        start = end + 1;
+        if (name.empty())
+            throw std::invalid_argument("fields must not contain empty names (a list must name at least one of type, energy and age)");
+        if (name == "type")
+            fields |= GRID_FIELD_TYPE;
+        else if (name == "energy")
+            fields |= GRID_FIELD_ENERGY;
+        else if (name == "age")
+            fields |= GRID_FIELD_AGE;
+        else
+            throw std::invalid_argument("fields must be a comma-separated list of type, energy and age");
+    }
+    return fields;
+}
+
+// Com todas as colunas, o mesmo texto de nlohmann::json(grid).dump(): chaves
+// em ordem alfabética e sem espaços, escrito direto das colunas da grade
+void writeGridJson(const grid_t &grid, std::string &out, uint32_t fields)
+{
+    const type_text_t &text = typeText();
+    const bool age = fields & GRID_FIELD_AGE;
+    const bool energy = fields & GRID_FIELD_ENERGY;
+    const bool type = fields & GRID_FIELD_TYPE;
+    // o que abre cada chave depende das que vêm antes dela no objeto
+    const char *energy_key = age ? ",\"energy\":" : "{\"energy\":";
+    const size_t energy_key_length = std::strlen(energy_key);
+    const std::array<std::string, 256> &type_text = age || energy ? text.suffix : text.alone;
+
+    text_stream_t stream(out);
+    stream.put('[');
+    for (uint32_t i = 0; i < grid.rows; i++)
+    {
+        if (i > 0)
+            stream.put(',');
+        stream.put('[');
+        for (uint32_t j = 0; j < grid.cols; j++)
+        {
+            const size_t idx = grid.index(i, j);
+            if (j > 0)
+                stream.put(',');
+            if (age)
+            {
+                stream.put("{\"age\":");
+                stream.putInt(grid.age[idx]);
+            }
+            if (energy)
+            {
+                stream.put(energy_key, energy_key_length);
+                stream.putInt(grid.energy[idx]);
+            }
+            if (type)
+                stream.put(type_text[grid.type[idx]]);
+            else
+                stream.put('}');
+        }
+        stream.put(']');
+    }
+    stream.put(']');
+}
+
+void writeGridCompactJson(const grid_t &grid, std::string &out, uint32_t fields)
+{
+    const type_text_t &text = typeText();
+    text_stream_t stream(out);
+    stream.put("{\"rows\":");
+    stream.putInt((int32_t)grid.rows);
+    stream.put(",\"cols\":");
+    stream.putInt((int32_t)grid.cols);
+    if (fields & GRID_FIELD_TYPE)
+    {
+        stream.put(",\"types\":[");
+        for (uint32_t i = 0; i < grid.rows; i++)
+        {
+            if (i > 0)
+                stream.put(',');
+            stream.put('"');
+            for (uint32_t j = 0; j < grid.cols; j++)
+                stream.put(text.symbol[grid.type[grid.index(i, j)]]);
+            stream.put('"');
+        }
+        stream.put(']');
+    }
+    if (fields & GRID_FIELD_ENERGY)
+    {
+        stream.put(",\"energy\":");
+        putRows(stream, grid, grid.energy);
+    }
+    if (fields & GRID_FIELD_AGE)
+    {
+        stream.put(",\"age\":");
+        putRows(stream, grid, grid.age);
+    }
+    stream.put('}');
+}
+
+std::string gridToJson(const grid_t &grid)
+{
+    std::string out;
+    writeGridJson(grid, out);
+    return out;
+}
+
+namespace
+{
+    void appendBytes(std::string &out, const void *data, size_t size)
+    {
+        out.append((const char *)data, size);
+    }
+}
+
+// As colunas são copiadas como estão na memória; o formato assume uma
+// máquina little-endian, como as máquinas x86 e ARM em que o projeto roda
+void writeGridBinary(const grid_t &grid, std::string &out, uint32_t fields)
+{
+    const bool all = fields == GRID_FIELDS_ALL;
+    const uint32_t header[5] = {GRID_BINARY_MAGIC, all ? GRID_BINARY_VERSION : GRID_BINARY_VERSION_FIELDS, grid.rows,
+                                grid.cols, fields};
+    const size_t header_size = all ? 4 * sizeof(uint32_t) : sizeof(header);
+    const size_t cell_size = (fields & GRID_FIELD_TYPE ? 1 : 0) + (fields & GRID_FIELD_ENERGY ? sizeof(int32_t) : 0) +
+                             (fields & GRID_FIELD_AGE ? sizeof(int32_t) : 0);
+    out.reserve(out.size() + header_size + grid.size() * cell_size);
+    appendBytes(out, header, header_size);
+    if (fields & GRID_FIELD_TYPE)
+        appendBytes(out, grid.type.data(), grid.size());
+    if (fields & GRID_FIELD_ENERGY)
+        appendBytes(out, grid.energy.data(), grid.size() * sizeof(int32_t));
+    if (fields & GRID_FIELD_AGE)
+        appendBytes(out, grid.age.data(), grid.size() * sizeof(int32_t));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "grid.h"
+#include "json.hpp"
+#include <string>
+
+// Auxiliary code to convert the entity_type_t enum to a string
+NLOHMANN_JSON_SERIALIZE_ENUM(entity_type_t, {
+                                                {empty, " "},
+                                                {plant, "P"},
+                                                {herbivore, "H"},
+                                                {carnivore, "C"},
+                                                {morta, "M"},
+                                            })
+
+// Auxiliary code to convert the entity_t struct to a JSON object
+namespace nlohmann
+{
+    void to_json(nlohmann::json &j, const entity_t &e);
+
+    // A grade é serializada como um array de linhas de entity_t
+    void to_json(nlohmann::json &j, const grid_t &g);
+}
+
+// Colunas da grade incluídas nas respostas (?fields=type,energy,age); os
+// serializadores pulam as outras por inteiro
+enum grid_field_t : uint32_t
+{
+    GRID_FIELD_TYPE = 1,
+    GRID_FIELD_ENERGY = 2,
+    GRID_FIELD_AGE = 4,
+    GRID_FIELDS_ALL = GRID_FIELD_TYPE | GRID_FIELD_ENERGY | GRID_FIELD_AGE
+};
+
+// Lê uma lista de colunas separadas por vírgula, ex.: "type,energy"; lança
+// std::invalid_argument para nomes desconhecidos ou vazios (ex.: "type,")
+uint32_t parseGridFields(const std::string &list);
+
+// Representação JSON da grade devolvida pelos endpoints: um array de linhas
+// de objetos {"age", "energy", "type"}, idêntico ao to_json() acima
+std::string gridToJson(const grid_t &grid);
+
+// O mesmo, acrescentado ao final de `out` sem montar o documento JSON: só
+// `out` cresce, então com um buffer reutilizado não há alocações. Os
+// objetos só trazem as chaves de `fields`
+void writeGridJson(const grid_t &grid, std::string &out, uint32_t fields = GRID_FIELDS_ALL);
+
+// Variante compacta do JSON (?format=compact), cerca de 5 vezes menor:
+//   {"rows": R, "cols": C, "types": ["PH C", ...], "energy": [[...], ...], "age": [[...], ...]}
+// com uma string de símbolos (os mesmos de entity_type_t acima) por linha e
+// arrays paralelos por linha para energia e idade; as chaves das colunas
+// fora de `fields` são omitidas
+void writeGridCompactJson(const grid_t &grid, std::string &out, uint32_t fields = GRID_FIELDS_ALL);
+
+// Formato binário da grade: cabeçalho de 16 bytes (magic "ECOG", versão,
+// rows, cols, todos uint32 little-endian) seguido das colunas inteiras
+// type (uint8), energy (int32) e age (int32). Com só parte das colunas o
+// cabeçalho é o da versão 2, com um quinto uint32 (os bits de
+// grid_field_t), e só as colunas pedidas vêm depois dele, na mesma ordem.
+const uint32_t GRID_BINARY_MAGIC = 0x474f4345; // "ECOG"
+const uint32_t GRID_BINARY_VERSION = 1;
+const uint32_t GRID_BINARY_VERSION_FIELDS = 2;
+
+// Acrescenta a grade em formato binário ao final de `out`
+void writeGridBinary(const grid_t &grid, std::string &out, uint32_t fields = GRID_FIELDS_ALL);
@@ -0,0 +1,110 @@
+#include "series.h"
+#include <stdexcept>
+
+population_sample_t populationSample(const world_t &world)
+{
+    population_sample_t sample;
+    sample.tick = world.tick;
+    sample.population[0] = (double)world.grid.population(plant);
+    for (size_t s = 0; s < STATS_SPECIES_COUNT; s++)
+    {
+        const species_stats_t &stats = world.stats.totals.species[STATS_SPECIES[s]];
+        sample.population[s + 1] = (double)stats.count;
+        sample.mean_energy[s] = stats.count ? (double)stats.energy_sum / stats.count : 0.0;
+    }
+    return sample;
+}
+
+population_series_t::population_series_t(size_t capacity)
+{
+    for (size_t r = 0; r < SERIES_RESOLUTION_COUNT; r++)
+    {
+        levels[r].resolution = SERIES_RESOLUTIONS[r];
+        levels[r].ring.resize(capacity);
+    }
+}
+
+void population_series_t::level_t::push(const population_sample_t &point)
+{
+    ring[head] = point;
+    head = (head + 1) % ring.size();
+    count = std::min(count + 1, ring.size());
+}
+
+void population_series_t::level_t::flush()
+{
+    if (samples == 0)
+        return;
+    population_sample_t point;
+    point.tick = sum.tick;
+    for (size_t s = 0; s < 3; s++)
+        point.population[s] = sum.population[s] / samples;
+    for (size_t a = 0; a < 2; a++)
+        point.mean_energy[a] = sum.population[a + 1] > 0 ? energy_sum[a] / sum.population[a + 1] : 0.0;
+    push(point);
+    sum = population_sample_t();
+    energy_sum[0] = energy_sum[1] = 0;
+    samples = 0;
+}
+
+void population_series_t::record(const population_sample_t &sample)
+{
+    levels[0].push(sample);
+    for (size_t r = 1; r < SERIES_RESOLUTION_COUNT; r++)
+    {
+        level_t &level = levels[r];
+        const uint64_t window = sample.tick - sample.tick % level.resolution;
+        if (level.samples > 0 && level.sum.tick != window)
+            level.flush();
+
+        // Energia média ponderada pela população de cada amostra
+        level.sum.tick = window;
+        for (size_t s = 0; s < 3; s++)
+            level.sum.population[s] += sample.population[s];
+        for (size_t a = 0; a < 2; a++)
+            level.energy_sum[a] += sample.mean_energy[a] * sample.population[a + 1];
+        level.samples++;
+        if (sample.tick % level.resolution == level.resolution - 1)
+            level.flush();
+    }
+}
+
+void population_series_t::clear()
+{
+    for (level_t &level : levels)
+    {
+        level.head = level.count = 0;
+        level.sum = population_sample_t();
+        level.energy_sum[0] = level.energy_sum[1] = 0;
+        level.samples = 0;
+    }
+}
+
+nlohmann::json population_series_t::query(uint64_t from, uint64_t to, uint32_t resolution) const
+{
+    const level_t *level = nullptr;
+    for (const level_t &l : levels)
+        if (l.resolution == resolution)
+            level = &l;
+    if (!level)
+        throw std::invalid_argument("resolution must be 1, 10 or 100");
+
+    std::vector<uint64_t> ticks;
+    std::vector<double> columns[5];
+    const size_t capacity = level->ring.size();
+    for (size_t k = 0; k < level->count; k++)
+    {
+        const population_sample_t &point = level->ring[(level->head + capacity - level->count + k) % capacity];
+        if (point.tick < from || point.tick > to)
+            continue;
+        ticks.push_back(point.tick);
+        for (size_t s = 0; s < 3; s++)
+            columns[s].push_back(point.population[s]);
+        for (size_t a = 0; a < 2; a++)
+            columns[3 + a].push_back(point.mean_energy[a]);
+    }
+    return {{"resolution", resolution},    {"tick", ticks},
+            {"plants", columns[0]},        {"herbivores", columns[1]},
+            {"carnivores", columns[2]},    {"herbivore_energy", columns[3]},
+            {"carnivore_energy", columns[4]}};
+}
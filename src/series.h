@@ -0,0 +1,63 @@
+#pragma once
+
+#include "json.hpp"
+#include "world.h"
+#include <cstdint>
+#include <vector>
+
+// Série temporal das populações guardada em memória para gráficos de
+// simulações longas. Cada iteração vira uma amostra; além das amostras
+// individuais há médias de 10 e de 100 iterações, cada resolução em um anel
+// de tamanho fixo, então a memória não cresce com a duração da simulação.
+const uint32_t SERIES_RESOLUTIONS[] = {1, 10, 100};
+const size_t SERIES_RESOLUTION_COUNT = 3;
+const size_t DEFAULT_SERIES_CAPACITY = 4096; // pontos por resolução
+
+struct population_sample_t
+{
+    uint64_t tick = 0;           // nas médias, a primeira iteração da janela
+    double population[3] = {};   // plantas, herbívoros, carnívoros
+    double mean_energy[2] = {};  // herbívoros, carnívoros
+};
+
+// Amostra do estado atual; world.stats precisa estar válido
+population_sample_t populationSample(const world_t &world);
+
+class population_series_t
+{
+public:
+    explicit population_series_t(size_t capacity = DEFAULT_SERIES_CAPACITY);
+
+    // Acrescenta a amostra de uma iteração. As médias usam janelas alinhadas
+    // a múltiplos da resolução e são fechadas quando chega uma amostra de
+    // outra janela ou a última da janela.
+    void record(const population_sample_t &sample);
+
+    // Esquece todas as amostras (o mundo foi substituído)
+    void clear();
+
+    // Pontos da resolução pedida (um dos SERIES_RESOLUTIONS) com iteração em
+    // [from, to], do mais antigo ao mais novo, em colunas: {"resolution",
+    // "tick": [...], "plants": [...], ..., "carnivore_energy": [...]}.
+    // Lança std::invalid_argument para outras resoluções.
+    nlohmann::json query(uint64_t from, uint64_t to, uint32_t resolution) const;
+
+private:
+    struct level_t
+    {
+        uint32_t resolution;
+        std::vector<population_sample_t> ring;
+        size_t head = 0;  // próxima posição a escrever
+        size_t count = 0; // pontos guardados
+
+        // Janela em andamento
+        population_sample_t sum;
+        double energy_sum[2] = {};
+        uint32_t samples = 0;
+
+        void push(const population_sample_t &point);
+        void flush();
+    };
+
+    level_t levels[SERIES_RESOLUTION_COUNT];
+};
@@ -0,0 +1,165 @@
+#include "snapshot.h"
+#include "file_io.h"
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    // Tamanho do cabeçalho da versão 1, que não tinha os offsets das colunas
+    const size_t SNAPSHOT_V1_HEADER_SIZE = offsetof(snapshot_header_t, type_offset);
+
+    uint64_t alignUp(uint64_t offset)
+    {
+        return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+    }
+
+    // Se [offset, offset + length) cabe em um arquivo de `size` bytes
+    bool fits(uint64_t offset, uint64_t length, uint64_t size)
+    {
+        return offset <= size && length <= size - offset;
+    }
+
+    // A coluna passa a apontar para o mapeamento se o offset estiver alinhado
+    // para T; senão (snapshots da versão 1) os dados são copiados
+    template <typename T>
+    column_t<T> mappedColumn(const std::shared_ptr<void> &mapping, uint64_t offset, size_t count)
+    {
+        char *data = (char *)mapping.get() + offset;
+        column_t<T> column;
+        if (offset % alignof(T) == 0)
+        {
+            column.adopt(mapping, (T *)data, count);
+        }
+        else
+        {
+            column.assign(count, T());
+            std::memcpy(column.data(), data, count * sizeof(T));
+        }
+        return column;
+    }
+}
+
+uint64_t saveSnapshot(const world_t &world, const std::string &path)
+{
+    static const char zeros[SNAPSHOT_ALIGNMENT] = {};
+    const grid_t &grid = world.grid;
+    const std::string params = paramsToJson(world.params).dump();
+
+    snapshot_header_t header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, grid.rows, grid.cols, world.seed, world.tick,
+                                (uint32_t)params.size(), packTopology(grid.topology), 0, 0, 0};
+    header.type_offset = alignUp(sizeof(header) + params.size());
+    header.energy_offset = alignUp(header.type_offset + grid.size());
+    header.age_offset = alignUp(header.energy_offset + grid.size() * sizeof(int32_t));
+    const uint64_t total = header.age_offset + grid.size() * sizeof(int32_t);
+
+    iovec iov[8] = {{&header, sizeof(header)},
+                    {(void *)params.data(), params.size()},
+                    {(void *)zeros, header.type_offset - sizeof(header) - params.size()},
+                    {(void *)grid.type.data(), grid.size()},
+                    {(void *)zeros, header.energy_offset - header.type_offset - grid.size()},
+                    {(void *)grid.energy.data(), grid.size() * sizeof(int32_t)},
+                    {(void *)zeros, header.age_offset - header.energy_offset - grid.size() * sizeof(int32_t)},
+                    {(void *)grid.age.data(), grid.size() * sizeof(int32_t)}};
+
+    const std::string tmp_path = path + ".tmp";
+    {
+        file_t file{open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)};
+        if (file.fd < 0)
+            throw ioError("cannot create", tmp_path);
+        writeAll(file.fd, iov, 8, tmp_path);
+        if (fsync(file.fd) != 0)
+            throw ioError("cannot sync", tmp_path);
+    }
+    if (rename(tmp_path.c_str(), path.c_str()) != 0)
+        throw ioError("cannot rename to", path);
+    return total;
+}
+
+void loadSnapshot(world_t &world, const std::string &path)
+{
+    file_t file{open(path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (file.fd < 0)
+        throw ioError("cannot open", path);
+
+    snapshot_header_t header = {};
+    readAll(file.fd, &header, SNAPSHOT_V1_HEADER_SIZE, path);
+    if (header.magic != SNAPSHOT_MAGIC)
+        throw std::runtime_error(path + ": not an ecosim snapshot");
+    if (header.version != 1 && header.version != SNAPSHOT_VERSION)
+        throw std::runtime_error(path + ": unsupported snapshot version " + std::to_string(header.version));
+    // o motor guarda índices de célula em 32 bits; o limite é o mesmo da
+    // criação do mundo pela API
+    const uint64_t cells = (uint64_t)header.rows * header.cols;
+    if (cells == 0 || cells > MAX_GRID_CELLS)
+        throw std::runtime_error(path + ": rows and cols must be positive and rows * cols at most " +
+                                 std::to_string(MAX_GRID_CELLS));
+    uint64_t header_size = SNAPSHOT_V1_HEADER_SIZE;
+    if (header.version == 1)
+    {
+        header.type_offset = header_size + header.params_size;
+        header.energy_offset = header.type_offset + cells;
+        header.age_offset = header.energy_offset + cells * sizeof(int32_t);
+    }
+    else
+    {
+        readAll(file.fd, (char *)&header + SNAPSHOT_V1_HEADER_SIZE, sizeof(header) - SNAPSHOT_V1_HEADER_SIZE, path);
+        header_size = sizeof(header);
+    }
+
+    struct stat st;
+    if (fstat(file.fd, &st) != 0)
+        throw ioError("cannot stat", path);
+    const uint64_t size = (uint64_t)st.st_size;
+    if (!fits(header_size, header.params_size, size) || !fits(header.type_offset, cells, size) ||
+        !fits(header.energy_offset, cells * sizeof(int32_t), size) || !fits(header.age_offset, cells * sizeof(int32_t), size))
+        throw std::runtime_error(path + ": snapshot size does not match its header");
+
+    // MAP_PRIVATE: as escritas da simulação nunca chegam ao arquivo
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file.fd, 0);
+    if (addr == MAP_FAILED)
+        throw ioError("cannot map", path);
+    std::shared_ptr<void> mapping(addr, [size](void *p) { munmap(p, size); });
+    const char *base = (const char *)addr;
+
+    rule_params_t params;
+    try
+    {
+        mergeParams(params, nlohmann::json::parse(base + header_size, base + header_size + header.params_size));
+    }
+    catch (const std::exception &e)
+    {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+
+    topology_t topology;
+    try
+    {
+        topology = unpackTopology(header.topology);
+        validateTopology(topology, header.rows, header.cols);
+    }
+    catch (const std::invalid_argument &e)
+    {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+
+    const uint8_t *types = (const uint8_t *)base + header.type_offset;
+    for (uint64_t c = 0; c < cells; c++)
+        if (types[c] >= ENTITY_TYPE_COUNT)
+            throw std::runtime_error(path + ": invalid entity type in snapshot");
+
+    // Monta um mundo novo para não deixar `world` pela metade
+    world_t loaded;
+    loaded.grid.adopt(header.rows, header.cols, mappedColumn<uint8_t>(mapping, header.type_offset, cells),
+                      mappedColumn<int32_t>(mapping, header.energy_offset, cells),
+                      mappedColumn<int32_t>(mapping, header.age_offset, cells), topology);
+    loaded.resetState(header.seed);
+    loaded.tick = header.tick;
+    loaded.setParams(params);
+
+    loaded.metrics = world.metrics;
+    world = std::move(loaded);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "world.h"
+#include <cstdint>
+#include <string>
+
+// Snapshot binário do estado completo de um mundo: grade e topologia,
+// iteração atual, parâmetros das regras e semente. O gerador de números aleatórios é baseado
+// em contador (ver rng.h), então semente e iteração bastam para que a
+// simulação continue exatamente como continuaria sem a interrupção.
+//
+// Formato (little-endian, versão 2):
+//   snapshot_header_t
+//   parâmetros em JSON (params_size bytes, ver paramsToJson())
+//   colunas inteiras type (uint8), energy (int32) e age (int32), cada uma
+//   começando em um múltiplo de SNAPSHOT_ALIGNMENT (os offsets estão no
+//   cabeçalho) e com zeros no espaço entre elas
+//
+// O alinhamento deixa cada coluna em páginas próprias, então o arquivo pode
+// ser mapeado e as colunas usadas diretamente como a grade do mundo: ao
+// carregar nada é copiado, e cada página só é copiada para a memória do
+// processo na primeira vez que a simulação a altera (copy-on-write).
+//
+// A versão 1 (colunas logo depois dos parâmetros, cabeçalho sem offsets)
+// ainda é lida, copiando as colunas.
+const uint32_t SNAPSHOT_MAGIC = 0x534f4345; // "ECOS"
+const uint32_t SNAPSHOT_VERSION = 2;
+const uint64_t SNAPSHOT_ALIGNMENT = 4096;
+
+struct snapshot_header_t
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t rows;
+    uint32_t cols;
+    uint64_t seed;
+    uint64_t tick;
+    uint32_t params_size;
+    uint32_t topology; // packTopology(); zero (von Neumann, clip) em arquivos antigos
+    // a partir da versão 2
+    uint64_t type_offset;
+    uint64_t energy_offset;
+    uint64_t age_offset;
+};
+static_assert(sizeof(snapshot_header_t) == 64, "snapshot header must be packed");
+
+// Grava o snapshot em `path` com uma única escrita sequencial das colunas, sem
+// copiá-las. O arquivo é escrito ao lado e renomeado no fim, então um
+// snapshot anterior com o mesmo nome nunca fica pela metade. Retorna o
+// tamanho do arquivo; lança std::runtime_error em caso de erro.
+uint64_t saveSnapshot(const world_t &world, const std::string &path);
+
+// Substitui o estado de `world` pelo do snapshot, mapeando o arquivo em
+// memória (só os mapas de ocupação são recalculados). Em caso de erro lança
+// std::runtime_error e `world` fica como estava.
+void loadSnapshot(world_t &world, const std::string &path);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "grid.h"
+
+// Constants (valores padrão dos parâmetros das regras)
+const int32_t PLANT_MAXIMUM_AGE = 10;
+const int32_t HERBIVORE_MAXIMUM_AGE = 50;
+const int32_t CARNIVORE_MAXIMUM_AGE = 80;
+const int32_t MAXIMUM_ENERGY = 100;
+const int32_t INITIAL_ENERGY = 100;
+const int32_t THRESHOLD_ENERGY_FOR_REPRODUCTION = 20;
+const int32_t MOVE_ENERGY_COST = 5;
+const int32_t REPRODUCTION_ENERGY_COST = 10;
+const int32_t HERBIVORE_EAT_ENERGY_GAIN = 30;
+const int32_t CARNIVORE_EAT_ENERGY_GAIN = 20;
+
+// Probabilities
+const double PLANT_REPRODUCTION_PROBABILITY = 0.2;
+const double HERBIVORE_REPRODUCTION_PROBABILITY = 0.075;
+const double CARNIVORE_REPRODUCTION_PROBABILITY = 0.025;
+const double HERBIVORE_MOVE_PROBABILITY = 0.7;
+const double HERBIVORE_EAT_PROBABILITY = 0.9;
+const double CARNIVORE_MOVE_PROBABILITY = 0.5;
+const double CARNIVORE_EAT_PROBABILITY = 1.0;
+
+// Políticas das espécies animais. Cada espécie é um conjunto de constantes
+// de compilação com o que define a sua estrutura (tipo, presas e células por
+// onde anda); os valores numéricos vêm do conjunto de regras em vigor (ver
+// params.h). O kernel genérico updateAnimal<Species>() é instanciado uma vez
+// por espécie, então não há despacho em tempo de execução.
+struct herbivore_traits_t
+{
+    static constexpr entity_type_t type = herbivore;
+    static constexpr uint32_t prey = speciesSet(plant);
+    static constexpr uint32_t passable = speciesSet(empty, plant); // onde pode se mover
+};
+
+struct carnivore_traits_t
+{
+    static constexpr entity_type_t type = carnivore;
+    static constexpr uint32_t prey = speciesSet(herbivore);
+    static constexpr uint32_t passable = speciesSet(empty, herbivore);
+};
+
+// Lista das espécies animais simuladas, na ordem em que agem em cada linha
+template <typename... Species>
+struct species_list_t
+{
+};
+
+using animal_species_t = species_list_t<herbivore_traits_t, carnivore_traits_t>;
+
+// Conjunto dos tipos de uma lista de espécies, ex.: speciesTypes(animal_species_t{})
+template <typename... Species>
+constexpr uint32_t speciesTypes(species_list_t<Species...>)
+{
+    return (speciesSet(Species::type) | ...);
+}
+
+// Presas do tipo de animal `type` (conjunto vazio se não for da lista)
+template <typename... Species>
+constexpr uint32_t preyOf(entity_type_t type, species_list_t<Species...>)
+{
+    return ((type == Species::type ? Species::prey : 0u) | ...);
+}
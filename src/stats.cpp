@@ -0,0 +1,99 @@
+#include "stats.h"
+#include <cstdio>
+
+namespace
+{
+    const char *speciesName(entity_type_t type)
+    {
+        switch (type)
+        {
+        case plant:
+            return "plant";
+        case herbivore:
+            return "herbivore";
+        case carnivore:
+            return "carnivore";
+        default:
+            return "unknown";
+        }
+    }
+}
+
+void population_stats_t::merge(const population_stats_t &delta)
+{
+    for (size_t t = 0; t < ENTITY_TYPE_COUNT; t++)
+    {
+        species_stats_t &s = species[t];
+        const species_stats_t &d = delta.species[t];
+        s.count += d.count;
+        s.energy_sum += d.energy_sum;
+        s.age_sum += d.age_sum;
+        for (size_t b = 0; b < AGE_HISTOGRAM_BUCKETS; b++)
+            s.age_histogram[b] += d.age_histogram[b];
+    }
+}
+
+void animal_stats_t::rebuild(const grid_t &grid)
+{
+    totals = population_stats_t();
+    for (entity_type_t type : STATS_SPECIES)
+        grid.occupancy[type].forEach([&](uint32_t i, uint32_t j) {
+            size_t idx = grid.index(i, j);
+            totals.add(type, grid.energy[idx], grid.age[idx]);
+        });
+    valid = true;
+}
+
+nlohmann::json statsToJson(const animal_stats_t &stats, const grid_t &grid, uint64_t tick)
+{
+    nlohmann::json species = nlohmann::json::object();
+    species[speciesName(plant)] = {{"count", grid.population(plant)}};
+    for (entity_type_t type : STATS_SPECIES)
+    {
+        const species_stats_t &s = stats.totals.species[type];
+        size_t used = AGE_HISTOGRAM_BUCKETS;
+        while (used > 0 && s.age_histogram[used - 1] == 0)
+            used--;
+        species[speciesName(type)] = {
+            {"count", s.count},
+            {"mean_energy", s.count ? (double)s.energy_sum / s.count : 0.0},
+            {"mean_age", s.count ? (double)s.age_sum / s.count : 0.0},
+            {"age_histogram", std::vector<int64_t>(s.age_histogram, s.age_histogram + used)}};
+    }
+    return {{"tick", tick}, {"species", std::move(species)}};
+}
+
+void writeStatsPrometheus(const animal_stats_t &stats, std::string &out)
+{
+    char line[256];
+    out += "# HELP ecosim_animal_energy_mean Mean energy of the animals of each species.\n"
+           "# TYPE ecosim_animal_energy_mean gauge\n";
+    for (entity_type_t type : STATS_SPECIES)
+    {
+        const species_stats_t &s = stats.totals.species[type];
+        std::snprintf(line, sizeof(line), "ecosim_animal_energy_mean{species=\"%s\"} %g\n", speciesName(type),
+                      s.count ? (double)s.energy_sum / s.count : 0.0);
+        out += line;
+    }
+
+    out += "# HELP ecosim_animal_age Age of the animals of each species, in ticks.\n"
+           "# TYPE ecosim_animal_age histogram\n";
+    for (entity_type_t type : STATS_SPECIES)
+    {
+        const species_stats_t &s = stats.totals.species[type];
+        int64_t cumulative = 0;
+        for (size_t b = 0; b < AGE_HISTOGRAM_BUCKETS; b++)
+        {
+            cumulative += s.age_histogram[b];
+            std::snprintf(line, sizeof(line), "ecosim_animal_age_bucket{species=\"%s\",le=\"%lld\"} %lld\n",
+                          speciesName(type), (long long)ageBucketBound(b), (long long)cumulative);
+            out += line;
+        }
+        std::snprintf(line, sizeof(line),
+                      "ecosim_animal_age_bucket{species=\"%s\",le=\"+Inf\"} %lld\n"
+                      "ecosim_animal_age_sum{species=\"%s\"} %lld\necosim_animal_age_count{species=\"%s\"} %lld\n",
+                      speciesName(type), (long long)s.count, speciesName(type), (long long)s.age_sum,
+                      speciesName(type), (long long)s.count);
+        out += line;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "grid.h"
+#include "json.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Espécies com estatísticas mantidas pelo motor. As plantas só têm a
+// contagem, que já vem dos mapas de ocupação: idade e morte delas mudam
+// dentro do kernel vetorizado, célula a célula.
+const entity_type_t STATS_SPECIES[] = {herbivore, carnivore};
+const size_t STATS_SPECIES_COUNT = 2;
+const uint32_t STATS_SPECIES_SET = speciesSet(herbivore, carnivore);
+
+// Histograma de idades em faixas de potências de 2: a faixa 0 tem a idade 0
+// e a faixa b > 0 as idades de 2^(b-1) a 2^b - 1
+const size_t AGE_HISTOGRAM_BUCKETS = 32;
+
+inline size_t ageBucket(int32_t age)
+{
+    return age <= 0 ? 0 : 32 - (size_t)__builtin_clz((uint32_t)age);
+}
+
+// Maior idade da faixa b
+inline int64_t ageBucketBound(size_t b) { return b == 0 ? 0 : ((int64_t)1 << b) - 1; }
+
+struct species_stats_t
+{
+    int64_t count = 0;
+    int64_t energy_sum = 0;
+    int64_t age_sum = 0;
+    int64_t age_histogram[AGE_HISTOGRAM_BUCKETS] = {};
+};
+
+// Somas por espécie (indexadas por entity_type_t). Também serve de
+// variação: cada thread acumula as suas com add()/remove() e no fim da
+// iteração elas são somadas aos totais com merge().
+struct population_stats_t
+{
+    species_stats_t species[ENTITY_TYPE_COUNT];
+
+    void add(entity_type_t type, int32_t energy, int32_t age) { change(type, energy, age, 1); }
+    void remove(entity_type_t type, int32_t energy, int32_t age) { change(type, energy, age, -1); }
+
+    void merge(const population_stats_t &delta);
+
+private:
+    void change(entity_type_t type, int32_t energy, int32_t age, int64_t sign)
+    {
+        species_stats_t &s = species[type];
+        s.count += sign;
+        s.energy_sum += sign * energy;
+        s.age_sum += sign * age;
+        s.age_histogram[ageBucket(age)] += sign;
+    }
+};
+
+// Estatísticas dos animais de um mundo: recalculadas por inteiro só quando a
+// grade é substituída, depois atualizadas pelos eventos de cada iteração
+// (mortes, presas comidas, nascimentos, gasto de energia, envelhecimento)
+struct animal_stats_t
+{
+    population_stats_t totals;
+    std::vector<population_stats_t> partials; // uma por thread do pool
+    bool valid = false;
+
+    // Recalcula os totais varrendo os animais da grade
+    void rebuild(const grid_t &grid);
+};
+
+// {"tick", "species": {"plant": {"count"}, "herbivore": {"count",
+// "mean_energy", "mean_age", "age_histogram": [...]}, ...}}; o histograma
+// vai só até a última faixa não vazia
+nlohmann::json statsToJson(const animal_stats_t &stats, const grid_t &grid, uint64_t tick);
+
+// Energia média e histograma de idades no formato texto do Prometheus
+void writeStatsPrometheus(const animal_stats_t &stats, std::string &out);
@@ -0,0 +1,209 @@
+#include "sweep.h"
+#include "placement.h"
+#include "world.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+    const entity_type_t SWEEP_SPECIES[] = {plant, herbivore, carnivore};
+    const char *const SWEEP_SPECIES_NAMES[] = {"plants", "herbivores", "carnivores"};
+    const size_t SWEEP_SPECIES_COUNT = 3;
+
+    // Parâmetros de uma combinação: o índice é decomposto em base mista,
+    // um dígito por eixo
+    rule_params_t combinationParams(const sweep_spec_t &spec, size_t combination)
+    {
+        rule_params_t params = spec.base;
+        nlohmann::json overrides = nlohmann::json::object();
+        for (const auto &axis : spec.axes)
+        {
+            // valores inteiros seguem como inteiros, que é o que os campos
+            // inteiros aceitam (ver mergeParams())
+            const double value = axis.second[combination % axis.second.size()];
+            if (value == std::floor(value) && std::fabs(value) <= (double)INT32_MAX)
+                overrides[axis.first] = (int64_t)value;
+            else
+                overrides[axis.first] = value;
+            combination /= axis.second.size();
+        }
+        mergeParams(params, overrides);
+        return params;
+    }
+
+    uint32_t readCount(const nlohmann::json &j, const char *key, uint32_t fallback)
+    {
+        if (!j.contains(key))
+            return fallback;
+        if (!j[key].is_number_unsigned())
+            throw std::invalid_argument(std::string(key) + " must be a non-negative integer");
+        return j[key].get<uint32_t>();
+    }
+}
+
+size_t sweep_spec_t::combinations() const
+{
+    size_t total = 1;
+    for (const auto &axis : axes)
+        total *= axis.second.size();
+    return total;
+}
+
+sweep_spec_t parseSweepSpec(const nlohmann::json &j)
+{
+    if (!j.is_object())
+        throw std::invalid_argument("sweep spec must be a JSON object");
+
+    sweep_spec_t spec;
+    spec.rows = readCount(j, "rows", spec.rows);
+    spec.cols = readCount(j, "cols", spec.cols);
+    spec.ticks = readCount(j, "ticks", spec.ticks);
+    spec.plants = readCount(j, "plants", 0);
+    spec.herbivores = readCount(j, "herbivores", 0);
+    spec.carnivores = readCount(j, "carnivores", 0);
+    if (spec.rows == 0 || spec.cols == 0 || (uint64_t)spec.rows * spec.cols > MAX_GRID_CELLS)
+        throw std::invalid_argument("rows and cols must be positive and rows * cols at most " +
+                                    std::to_string(MAX_GRID_CELLS));
+    if (spec.ticks > MAX_SWEEP_TICKS)
+        throw std::invalid_argument("ticks must be at most " + std::to_string(MAX_SWEEP_TICKS));
+    if ((uint64_t)spec.plants + spec.herbivores + spec.carnivores > (uint64_t)spec.rows * spec.cols)
+        throw std::invalid_argument("Too many entities");
+    spec.topology = parseTopology(j);
+    validateTopology(spec.topology, spec.rows, spec.cols);
+
+    if (j.contains("parameters"))
+        mergeParams(spec.base, j["parameters"]);
+
+    if (j.contains("sweep"))
+    {
+        if (!j["sweep"].is_object())
+            throw std::invalid_argument("sweep must map parameter names to arrays of values");
+        for (auto it = j["sweep"].begin(); it != j["sweep"].end(); ++it)
+        {
+            if (!it.value().is_array() || it.value().empty())
+                throw std::invalid_argument(it.key() + " must be a non-empty array");
+            std::vector<double> values;
+            for (const auto &v : it.value())
+            {
+                if (!v.is_number())
+                    throw std::invalid_argument(it.key() + " values must be numbers");
+                values.push_back(v.get<double>());
+            }
+            spec.axes.emplace_back(it.key(), std::move(values));
+        }
+    }
+
+    if (j.contains("seeds"))
+    {
+        spec.seeds.clear();
+        const nlohmann::json &seeds = j["seeds"];
+        if (seeds.is_number_unsigned())
+        {
+            if (seeds.get<uint64_t>() > MAX_SWEEP_SEEDS)
+                throw std::invalid_argument("seeds must be at most " + std::to_string(MAX_SWEEP_SEEDS));
+            for (uint64_t s = 1; s <= seeds.get<uint64_t>(); s++)
+                spec.seeds.push_back(s);
+        }
+        else if (seeds.is_array())
+        {
+            for (const auto &s : seeds)
+            {
+                if (!s.is_number_unsigned())
+                    throw std::invalid_argument("seeds must be non-negative integers");
+                spec.seeds.push_back(s.get<uint64_t>());
+            }
+        }
+        if (spec.seeds.empty() || spec.seeds.size() > MAX_SWEEP_SEEDS)
+            throw std::invalid_argument("seeds must be a positive count or a non-empty array of at most " +
+                                        std::to_string(MAX_SWEEP_SEEDS));
+    }
+
+    // mundos * amostras, conferido fator a fator para o produto não estourar
+    uint64_t samples = (uint64_t)spec.ticks + 1;
+    auto multiply = [&](uint64_t factor) {
+        if (samples > MAX_SWEEP_SAMPLES / factor)
+            throw std::invalid_argument("runs * (ticks + 1) must be at most " + std::to_string(MAX_SWEEP_SAMPLES));
+        samples *= factor;
+    };
+    for (const auto &axis : spec.axes)
+        multiply(axis.second.size());
+    multiply(spec.seeds.size());
+
+    // Valida todas as combinações antes de começar
+    for (size_t c = 0; c < spec.combinations(); c++)
+        combinationParams(spec, c);
+    return spec;
+}
+
+void runSweep(const sweep_spec_t &spec, unsigned num_threads, std::ostream &csv,
+              std::atomic<size_t> *completed_runs)
+{
+    const size_t combinations = spec.combinations();
+    const size_t seeds = spec.seeds.size();
+    const size_t samples = (size_t)spec.ticks + 1; // inclui o estado inicial
+
+    // populations[run][amostra][espécie]; run = combinação * sementes + semente
+    std::vector<uint32_t> populations(spec.runs() * samples * SWEEP_SPECIES_COUNT);
+
+    worker_pool_t pool(num_threads);
+    pool.parallelFor(spec.runs(), [&](size_t run) {
+        worker_pool_t serial(1); // o mundo inteiro roda nesta thread
+        world_t world;
+        world.reset(spec.rows, spec.cols, spec.seeds[run % seeds], spec.topology);
+        world.setParams(combinationParams(spec, run / seeds));
+        placeEntities(world, spec.plants, spec.herbivores, spec.carnivores);
+
+        uint32_t *out = populations.data() + run * samples * SWEEP_SPECIES_COUNT;
+        for (size_t t = 0; t < samples; t++)
+        {
+            if (t > 0)
+                simulateTick(world, serial);
+            for (size_t s = 0; s < SWEEP_SPECIES_COUNT; s++)
+                *out++ = (uint32_t)world.grid.population(SWEEP_SPECIES[s]);
+        }
+        if (completed_runs)
+            completed_runs->fetch_add(1);
+    });
+
+    csv << "combination";
+    for (const auto &axis : spec.axes)
+        csv << ',' << axis.first;
+    csv << ",tick,seeds";
+    for (const char *name : SWEEP_SPECIES_NAMES)
+        csv << ',' << name << "_mean," << name << "_stddev," << name << "_min," << name << "_max";
+    csv << '\n';
+
+    for (size_t c = 0; c < combinations; c++)
+    {
+        for (size_t t = 0; t < samples; t++)
+        {
+            csv << c;
+            size_t digits = c;
+            for (const auto &axis : spec.axes)
+            {
+                csv << ',' << axis.second[digits % axis.second.size()];
+                digits /= axis.second.size();
+            }
+            csv << ',' << t << ',' << seeds;
+
+            for (size_t s = 0; s < SWEEP_SPECIES_COUNT; s++)
+            {
+                double sum = 0, sum_sq = 0;
+                uint32_t lo = UINT32_MAX, hi = 0;
+                for (size_t k = 0; k < seeds; k++)
+                {
+                    uint32_t v = populations[((c * seeds + k) * samples + t) * SWEEP_SPECIES_COUNT + s];
+                    sum += v;
+                    sum_sq += (double)v * v;
+                    lo = std::min(lo, v);
+                    hi = std::max(hi, v);
+                }
+                double mean = sum / seeds;
+                double stddev = std::sqrt(std::max(0.0, sum_sq / seeds - mean * mean));
+                csv << ',' << mean << ',' << stddev << ',' << lo << ',' << hi;
+            }
+            csv << '\n';
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "json.hpp"
+#include "params.h"
+#include "topology.h"
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Descrição de uma varredura de parâmetros: todas as combinações dos valores
+// em `axes` são simuladas com cada semente de `seeds`, em mundos
+// independentes. Em JSON:
+//   {"rows": 64, "cols": 64, "ticks": 200,
+//    "plants": 400, "herbivores": 100, "carnivores": 20,
+//    "neighbourhood": "moore", "boundary": "torus", // opcionais, ver topology.h
+//    "parameters": {...},                 // base, ver params.h
+//    "sweep": {"herbivore_move_probability": [0.5, 0.7, 0.9]},
+//    "seeds": [1, 2, 3]}                  // ou um número N = sementes 1..N
+struct sweep_spec_t
+{
+    uint32_t rows = 64;
+    uint32_t cols = 64;
+    uint32_t ticks = 100;
+    uint32_t plants = 0;
+    uint32_t herbivores = 0;
+    uint32_t carnivores = 0;
+    topology_t topology;
+    rule_params_t base;
+    std::vector<std::pair<std::string, std::vector<double>>> axes;
+    std::vector<uint64_t> seeds{1};
+
+    size_t combinations() const;
+    size_t runs() const { return combinations() * seeds.size(); }
+};
+
+// Limites de uma varredura, para que uma descrição não esgote a memória: a
+// grade segue MAX_GRID_CELLS (grid.h) e o resultado guarda 3 populações por
+// mundo e amostra (iterações + 1)
+const uint32_t MAX_SWEEP_TICKS = 100000;
+const uint64_t MAX_SWEEP_SEEDS = 10000;
+const uint64_t MAX_SWEEP_SAMPLES = 1ull << 24; // mundos * amostras
+
+// Lança std::invalid_argument se a descrição for inválida ou passar dos
+// limites acima
+sweep_spec_t parseSweepSpec(const nlohmann::json &j);
+
+// Simula todos os mundos da varredura usando num_threads threads (0 = todos
+// os núcleos), cada mundo inteiro em uma thread. Escreve um CSV com uma
+// linha por combinação e iteração: valores dos eixos e média, desvio padrão,
+// mínimo e máximo de cada população entre as sementes. `completed_runs`, se
+// não for nulo, é incrementado a cada mundo terminado.
+void runSweep(const sweep_spec_t &spec, unsigned num_threads, std::ostream &csv,
+              std::atomic<size_t> *completed_runs = nullptr);
@@ -0,0 +1,81 @@
+#include "topology.h"
+#include <stdexcept>
+
+const char *neighbourhoodName(neighbourhood_t neighbourhood)
+{
+    switch (neighbourhood)
+    {
+    case NEIGHBOURHOOD_VON_NEUMANN:
+        return "von_neumann";
+    case NEIGHBOURHOOD_MOORE:
+        return "moore";
+    case NEIGHBOURHOOD_HEX:
+        return "hex";
+    default:
+        return "unknown";
+    }
+}
+
+const char *boundaryName(boundary_t boundary)
+{
+    switch (boundary)
+    {
+    case BOUNDARY_CLIP:
+        return "clip";
+    case BOUNDARY_TORUS:
+        return "torus";
+    case BOUNDARY_REFLECT:
+        return "reflect";
+    default:
+        return "unknown";
+    }
+}
+
+topology_t parseTopology(const nlohmann::json &j)
+{
+    topology_t topology;
+    if (j.contains("neighbourhood"))
+    {
+        const nlohmann::json &v = j["neighbourhood"];
+        size_t n = 0;
+        while (n < NEIGHBOURHOOD_COUNT && !(v.is_string() && v.get<std::string>() == neighbourhoodName((neighbourhood_t)n)))
+            n++;
+        if (n == NEIGHBOURHOOD_COUNT)
+            throw std::invalid_argument("neighbourhood must be von_neumann, moore or hex");
+        topology.neighbourhood = (neighbourhood_t)n;
+    }
+    if (j.contains("boundary"))
+    {
+        const nlohmann::json &v = j["boundary"];
+        size_t b = 0;
+        while (b < BOUNDARY_COUNT && !(v.is_string() && v.get<std::string>() == boundaryName((boundary_t)b)))
+            b++;
+        if (b == BOUNDARY_COUNT)
+            throw std::invalid_argument("boundary must be clip, torus or reflect");
+        topology.boundary = (boundary_t)b;
+    }
+    return topology;
+}
+
+void validateTopology(const topology_t &topology, uint32_t rows, uint32_t cols)
+{
+    if (topology.boundary != BOUNDARY_CLIP && (rows < 3 || cols < 3))
+        throw std::invalid_argument(std::string("boundary ") + boundaryName(topology.boundary) +
+                                    " needs at least 3 rows and 3 cols");
+    if (topology.neighbourhood == NEIGHBOURHOOD_HEX && topology.boundary == BOUNDARY_TORUS && rows % 2 != 0)
+        throw std::invalid_argument("hex neighbourhood on a torus needs an even number of rows");
+}
+
+uint32_t packTopology(const topology_t &topology)
+{
+    return (uint32_t)topology.neighbourhood | (uint32_t)topology.boundary << 8;
+}
+
+topology_t unpackTopology(uint32_t packed)
+{
+    uint32_t neighbourhood = packed & 0xff;
+    uint32_t boundary = packed >> 8;
+    if (neighbourhood >= NEIGHBOURHOOD_COUNT || boundary >= BOUNDARY_COUNT)
+        throw std::invalid_argument("unknown topology " + std::to_string(packed));
+    return {(neighbourhood_t)neighbourhood, (boundary_t)boundary};
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "json.hpp"
+#include <cstdint>
+#include <string>
+
+// Vizinhança e condição de contorno da grade, escolhidas na criação do
+// mundo. Os kernels são instanciados para cada combinação (ver
+// dispatchTopology()), então a topologia não é testada célula a célula.
+enum neighbourhood_t : uint8_t
+{
+    NEIGHBOURHOOD_VON_NEUMANN, // 4 vizinhos ortogonais
+    NEIGHBOURHOOD_MOORE,       // 8 vizinhos, incluindo as diagonais
+    NEIGHBOURHOOD_HEX,         // 6 vizinhos, hexágonos em linhas deslocadas
+    NEIGHBOURHOOD_COUNT
+};
+
+enum boundary_t : uint8_t
+{
+    BOUNDARY_CLIP,    // células da borda têm menos vizinhos
+    BOUNDARY_TORUS,   // as bordas opostas se tocam
+    BOUNDARY_REFLECT, // o vizinho além da borda é o espelho dentro da grade
+    BOUNDARY_COUNT
+};
+
+struct topology_t
+{
+    neighbourhood_t neighbourhood = NEIGHBOURHOOD_VON_NEUMANN;
+    boundary_t boundary = BOUNDARY_CLIP;
+};
+
+struct offset_t
+{
+    int32_t di;
+    int32_t dj;
+};
+
+// Vizinhanças: deslocamentos na ordem em que os sorteios os indexam. A de
+// von Neumann mantém a ordem original (baixo, direita, esquerda, cima) e as
+// outras começam por ela.
+struct von_neumann_t
+{
+    static constexpr uint32_t count = 4;
+    static constexpr offset_t offsets[count] = {{1, 0}, {0, 1}, {0, -1}, {-1, 0}};
+    static const offset_t *at(uint32_t) { return offsets; }
+};
+
+struct moore_t
+{
+    static constexpr uint32_t count = 8;
+    static constexpr offset_t offsets[count] = {{1, 0}, {0, 1}, {0, -1}, {-1, 0}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    static const offset_t *at(uint32_t) { return offsets; }
+};
+
+// As linhas ímpares ficam meia célula à direita das pares, então as
+// diagonais dependem da paridade da linha
+struct hex_t
+{
+    static constexpr uint32_t count = 6;
+    static constexpr offset_t even[count] = {{1, 0}, {0, 1}, {0, -1}, {-1, 0}, {1, -1}, {-1, -1}};
+    static constexpr offset_t odd[count] = {{1, 0}, {0, 1}, {0, -1}, {-1, 0}, {1, 1}, {-1, 1}};
+    static const offset_t *at(uint32_t i) { return (i & 1) ? odd : even; }
+};
+
+// Contornos: wrap() leva uma coordenada vizinha (de -1 a n) para dentro da
+// grade. Só é chamado para vizinhos que existem, ver bitboard_t.
+struct clip_t
+{
+    static constexpr boundary_t id = BOUNDARY_CLIP;
+    static int64_t wrap(int64_t x, uint32_t) { return x; }
+};
+
+struct torus_t
+{
+    static constexpr boundary_t id = BOUNDARY_TORUS;
+    static int64_t wrap(int64_t x, uint32_t n) { return x < 0 ? x + n : x >= n ? x - n : x; }
+};
+
+struct reflect_t
+{
+    static constexpr boundary_t id = BOUNDARY_REFLECT;
+    static int64_t wrap(int64_t x, uint32_t n) { return x < 0 ? -x : x >= n ? 2 * ((int64_t)n - 1) - x : x; }
+};
+
+// Célula de dentro da grade que a coordenada de borda `x` (-1 ou n) repete,
+// ou -1 se ela não tem vizinho (contorno clip, ou reflect com n < 2)
+inline int64_t ghostSource(boundary_t boundary, int64_t x, uint32_t n)
+{
+    int64_t source = boundary == BOUNDARY_TORUS     ? torus_t::wrap(x, n)
+                     : boundary == BOUNDARY_REFLECT ? reflect_t::wrap(x, n)
+                                                    : -1;
+    return source >= 0 && source < n ? source : -1;
+}
+
+// Chama fn(vizinhança, contorno) com os tipos de política da topologia
+template <typename Fn>
+void dispatchTopology(const topology_t &topology, Fn &&fn)
+{
+    auto withBoundary = [&](auto neighbourhood) {
+        switch (topology.boundary)
+        {
+        case BOUNDARY_TORUS:
+            fn(neighbourhood, torus_t{});
+            break;
+        case BOUNDARY_REFLECT:
+            fn(neighbourhood, reflect_t{});
+            break;
+        default:
+            fn(neighbourhood, clip_t{});
+        }
+    };
+    switch (topology.neighbourhood)
+    {
+    case NEIGHBOURHOOD_MOORE:
+        withBoundary(moore_t{});
+        break;
+    case NEIGHBOURHOOD_HEX:
+        withBoundary(hex_t{});
+        break;
+    default:
+        withBoundary(von_neumann_t{});
+    }
+}
+
+const char *neighbourhoodName(neighbourhood_t neighbourhood);
+const char *boundaryName(boundary_t boundary);
+
+// Lê os campos opcionais "neighbourhood" ("von_neumann", "moore", "hex") e
+// "boundary" ("clip", "torus", "reflect") de um objeto JSON; lança
+// std::invalid_argument para outros valores
+topology_t parseTopology(const nlohmann::json &j);
+
+// Confere se a topologia vale para uma grade rows x cols: os contornos torus
+// e reflect pedem ao menos 3 linhas e 3 colunas (senão uma célula é vizinha
+// de si mesma ou do mesmo vizinho duas vezes), e a vizinhança hexagonal no
+// toro pede número par de linhas para a paridade das linhas se manter ao dar
+// a volta. Lança std::invalid_argument.
+void validateTopology(const topology_t &topology, uint32_t rows, uint32_t cols);
+
+// Representação compacta usada nos snapshots: vizinhança | contorno << 8.
+// Lança std::invalid_argument se o valor não for uma topologia conhecida.
+uint32_t packTopology(const topology_t &topology);
+topology_t unpackTopology(uint32_t packed);
@@ -0,0 +1,151 @@
+#include "trace.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+std::atomic<bool> trace_enabled{false};
+
+namespace
+{
+    // Eventos guardados por thread em cada captura; os excedentes são descartados
+    const uint32_t TRACE_BUFFER_EVENTS = 1 << 16;
+
+    struct trace_record_t
+    {
+        const char *name;
+        const char *category;
+        const char *arg_name;
+        int64_t arg_value;
+        uint64_t ts_ns;
+        char phase;
+    };
+
+    // Buffer de uma thread. Só a thread dona escreve; a captura lê os
+    // primeiros `count` registros depois de ler `count` com acquire. Um buffer
+    // pertence a uma sessão: ao ver uma sessão nova a dona recomeça do zero.
+    struct trace_buffer_t
+    {
+        uint32_t tid = 0;
+        std::atomic<bool> in_use{false};
+        std::atomic<uint64_t> session{0};
+        std::atomic<uint32_t> count{0};
+        std::atomic<uint64_t> dropped{0};
+        std::unique_ptr<trace_record_t[]> records;
+    };
+
+    std::atomic<uint64_t> trace_session{0};
+    std::atomic<int64_t> trace_start_ns{0}; // início da captura atual
+
+    int64_t steadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    // Buffers de todas as threads que já gravaram algo. Os de threads que
+    // terminaram são reaproveitados, então o total fica limitado ao maior
+    // número de threads vivas ao mesmo tempo.
+    std::mutex mtx_buffers;
+    std::vector<std::unique_ptr<trace_buffer_t>> buffers;
+
+    std::mutex mtx_capture;
+
+    trace_buffer_t *acquireBuffer()
+    {
+        std::lock_guard<std::mutex> lock(mtx_buffers);
+        for (auto &buffer : buffers)
+        {
+            bool free = false;
+            if (buffer->in_use.compare_exchange_strong(free, true))
+                return buffer.get();
+        }
+        buffers.push_back(std::make_unique<trace_buffer_t>());
+        trace_buffer_t *buffer = buffers.back().get();
+        buffer->tid = (uint32_t)buffers.size();
+        buffer->in_use = true;
+        buffer->records.reset(new trace_record_t[TRACE_BUFFER_EVENTS]);
+        return buffer;
+    }
+
+    // Devolve o buffer quando a thread termina
+    struct thread_buffer_t
+    {
+        trace_buffer_t *buffer = nullptr;
+        ~thread_buffer_t()
+        {
+            if (buffer)
+                buffer->in_use = false;
+        }
+    };
+
+    thread_local thread_buffer_t thread_buffer;
+}
+
+void traceEvent(char phase, const char *name, const char *category, const char *arg_name, int64_t arg_value)
+{
+    uint64_t ts_ns = (uint64_t)(steadyNanoseconds() - trace_start_ns.load(std::memory_order_relaxed));
+    if (!thread_buffer.buffer)
+        thread_buffer.buffer = acquireBuffer();
+    trace_buffer_t &buffer = *thread_buffer.buffer;
+
+    uint64_t session = trace_session.load(std::memory_order_acquire);
+    if (buffer.session.load(std::memory_order_relaxed) != session)
+    {
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.dropped.store(0, std::memory_order_relaxed);
+        buffer.session.store(session, std::memory_order_release);
+    }
+
+    uint32_t n = buffer.count.load(std::memory_order_relaxed);
+    if (n >= TRACE_BUFFER_EVENTS)
+    {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.records[n] = {name, category, arg_name, arg_value, ts_ns, phase};
+    buffer.count.store(n + 1, std::memory_order_release);
+}
+
+bool captureTrace(double seconds, std::string &out)
+{
+    std::unique_lock<std::mutex> capture(mtx_capture, std::try_to_lock);
+    if (!capture.owns_lock())
+        return false;
+
+    trace_start_ns = steadyNanoseconds();
+    uint64_t session = trace_session.fetch_add(1) + 1;
+    trace_enabled = true;
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    trace_enabled = false;
+
+    out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    char line[320];
+    bool first = true;
+    uint64_t dropped = 0;
+    std::lock_guard<std::mutex> lock(mtx_buffers);
+    for (const auto &buffer : buffers)
+    {
+        if (buffer->session.load(std::memory_order_acquire) != session)
+            continue;
+        uint32_t n = buffer->count.load(std::memory_order_acquire);
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+        for (uint32_t k = 0; k < n; k++)
+        {
+            const trace_record_t &r = buffer->records[k];
+            int len = std::snprintf(line, sizeof(line), "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                                    first ? "" : ",", r.name, r.category, r.phase, (double)r.ts_ns * 1e-3, buffer->tid);
+            if (r.arg_name)
+                std::snprintf(line + len, sizeof(line) - len, ",\"args\":{\"%s\":%lld}}", r.arg_name, (long long)r.arg_value);
+            else
+                std::snprintf(line + len, sizeof(line) - len, "}");
+            out += line;
+            first = false;
+        }
+    }
+    std::snprintf(line, sizeof(line), "],\"otherData\":{\"dropped_events\":%llu}}", (unsigned long long)dropped);
+    out += line;
+    return true;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Rastreamento opcional no formato Chrome trace (chrome://tracing, Perfetto).
+// Cada thread grava eventos de início/fim em um buffer próprio, sem travas;
+// fora de uma captura o custo de um evento é uma leitura atômica.
+
+extern std::atomic<bool> trace_enabled;
+
+inline bool traceEnabled() { return trace_enabled.load(std::memory_order_relaxed); }
+
+// Grava um evento na thread atual. `name`, `category` e `arg_name` precisam
+// ser strings estáticas; arg_name nulo = sem argumento
+void traceEvent(char phase, const char *name, const char *category, const char *arg_name = nullptr,
+                int64_t arg_value = 0);
+
+// Evento de início na construção e de fim na destruição, se a captura
+// estiver ativa quando o escopo começou
+class trace_scope_t
+{
+public:
+    trace_scope_t(const char *name, const char *category, const char *arg_name = nullptr, int64_t arg_value = 0)
+        : name(name), category(category), active(traceEnabled())
+    {
+        if (active)
+            traceEvent('B', name, category, arg_name, arg_value);
+    }
+
+    ~trace_scope_t()
+    {
+        if (active)
+            traceEvent('E', name, category);
+    }
+
+    trace_scope_t(const trace_scope_t &) = delete;
+    trace_scope_t &operator=(const trace_scope_t &) = delete;
+
+private:
+    const char *name;
+    const char *category;
+    bool active;
+};
+
+// Ativa o rastreamento por `seconds` segundos (bloqueando a thread que chama)
+// e escreve em `out` o JSON do Chrome trace com os eventos de todas as
+// threads. Retorna false, sem esperar, se outra captura estiver em andamento.
+bool captureTrace(double seconds, std::string &out);
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Referência a uma tarefa de parallelForWorkers(), sem cópia: ao contrário
+// de std::function, não aloca memória para lambdas com muitas capturas, então
+// iniciar uma fase não custa alocações
+class task_ref_t
+{
+public:
+    template <typename Fn>
+    explicit task_ref_t(Fn &fn)
+        : object((void *)&fn), call([](void *o, size_t k, unsigned worker) { (*static_cast<Fn *>(o))(k, worker); })
+    {
+    }
+
+    void operator()(size_t k, unsigned worker) const { call(object, k, worker); }
+
+private:
+    void *object;
+    void (*call)(void *, size_t, unsigned);
+};
+
+// Conjunto fixo de threads que executam as tarefas de uma fase da iteração.
+// As threads são criadas uma vez e ficam esperando a próxima fase, em vez de
+// uma thread nova por entidade a cada iteração.
+class worker_pool_t
+{
+public:
+    // num_threads = 0 usa o número de núcleos da máquina
+    explicit worker_pool_t(unsigned num_threads = 0)
+    {
+        if (num_threads == 0)
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        // a thread que chama parallelFor também trabalha
+        for (unsigned t = 1; t < num_threads; t++)
+            workers.emplace_back([this, t] { workerLoop(t); });
+    }
+
+    ~worker_pool_t()
+    {
+        {
+            std::lock_guard<profiled_mutex_t> lock(mtx);
+            stopping = true;
+        }
+        cv_start.notify_all();
+        for (std::thread &t : workers)
+            t.join();
+    }
+
+    worker_pool_t(const worker_pool_t &) = delete;
+    worker_pool_t &operator=(const worker_pool_t &) = delete;
+
+    unsigned size() const { return (unsigned)workers.size() + 1; }
+
+    // Executa fn(0) ... fn(n - 1) distribuídas entre as threads e só retorna
+    // quando todas terminarem
+    template <typename Fn>
+    void parallelFor(size_t n, Fn &&fn)
+    {
+        parallelForWorkers(n, [&fn](size_t k, unsigned) { fn(k); });
+    }
+
+    // Como parallelFor(), mas fn(k, worker) também recebe o índice da thread
+    // que executa a tarefa (0 .. size() - 1, 0 é a que chamou), para acumular
+    // resultados parciais por thread sem travas.
+    //
+    // Uma exceção lançada por uma tarefa não derruba a thread que a executa:
+    // a thread para de pegar tarefas, as outras terminam as que faltam e a
+    // primeira exceção é relançada aqui, na thread que chamou.
+    template <typename Fn>
+    void parallelForWorkers(size_t n, Fn &&fn)
+    {
+        run(n, task_ref_t(fn));
+    }
+
+private:
+    void run(size_t n, task_ref_t fn)
+    {
+        if (n == 0)
+            return;
+        if (workers.empty() || n == 1)
+        {
+            for (size_t k = 0; k < n; k++)
+                fn(k, 0);
+            return;
+        }
+
+        {
+            std::lock_guard<profiled_mutex_t> lock(mtx);
+            task = &fn;
+            task_error = nullptr;
+            task_count = n;
+            next_task.store(0);
+            pending = workers.size();
+            generation++;
+        }
+        cv_start.notify_all();
+
+        runTasks(fn, n, 0);
+
+        std::unique_lock<profiled_mutex_t> lock(mtx);
+        cv_done.wait(lock, [this] { return pending == 0; });
+        task = nullptr;
+        if (task_error)
+            std::rethrow_exception(std::exchange(task_error, nullptr));
+    }
+
+    void runTasks(task_ref_t fn, size_t n, unsigned worker)
+    {
+        try
+        {
+            for (size_t k = next_task.fetch_add(1); k < n; k = next_task.fetch_add(1))
+                fn(k, worker);
+        }
+        catch (...)
+        {
+            std::lock_guard<profiled_mutex_t> lock(mtx);
+            if (!task_error)
+                task_error = std::current_exception();
+        }
+    }
+
+    void workerLoop(unsigned worker)
+    {
+        uint64_t seen = 0;
+        while (true)
+        {
+            const task_ref_t *fn;
+            size_t n;
+            {
+                std::unique_lock<profiled_mutex_t> lock(mtx);
+                cv_start.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+                fn = task;
+                n = task_count;
+            }
+
+            runTasks(*fn, n, worker);
+
+            std::lock_guard<profiled_mutex_t> lock(mtx);
+            if (--pending == 0)
+                cv_done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    profiled_mutex_t mtx{"worker_pool"};
+    std::condition_variable_any cv_start;
+    std::condition_variable_any cv_done;
+    const task_ref_t *task = nullptr;
+    std::exception_ptr task_error; // primeira exceção das tarefas da fase atual
+    size_t task_count = 0;
+    std::atomic<size_t> next_task{0};
+    size_t pending = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,459 @@
+#include "world.h"
+#include "plant_kernel.h"
+#include "rng.h"
+#include "species.h"
+#include "trace.h"
+#include <algorithm>
+#include <type_traits>
+
+namespace
+{
+    struct animal_keys_t
+    {
+        uint32_t move;
+        uint32_t move_direction;
+        uint32_t move_priority;
+        uint32_t eat;
+        uint32_t eat_direction;
+        uint32_t reproduction;
+        uint32_t reproduction_direction;
+    };
+
+    animal_keys_t animalKeys(uint64_t seed, uint64_t tick)
+    {
+        return {streamKey(seed, tick, STREAM_MOVE),         streamKey(seed, tick, STREAM_MOVE_DIRECTION),
+                streamKey(seed, tick, STREAM_MOVE_PRIORITY), streamKey(seed, tick, STREAM_EAT),
+                streamKey(seed, tick, STREAM_EAT_DIRECTION), streamKey(seed, tick, STREAM_REPRODUCTION),
+                streamKey(seed, tick, STREAM_REPRODUCTION_DIRECTION)};
+    }
+
+    constexpr uint32_t ANIMAL_SET = speciesTypes(animal_species_t{});
+
+    // Pedido de movimento de uma célula com animal (world.move_proposals): o
+    // índice do vizinho de destino nos deslocamentos da vizinhança ou um
+    // destes valores
+    const uint8_t MOVE_STAY = 0xFF; // não sorteou movimento ou não tinha para onde ir
+    const uint8_t MOVE_DIE = 0xFE;  // morre nesta iteração
+
+    // Listas de movimentos de cada faixa de origem, separadas pela faixa de
+    // destino: a de cima, a mesma ou a de baixo (com volta no toro)
+    enum move_list_t : uint32_t
+    {
+        MOVES_UP,
+        MOVES_SAME,
+        MOVES_DOWN,
+        MOVE_LIST_COUNT
+    };
+
+    uint32_t bandCount(const grid_t &grid) { return (grid.rows + ANIMAL_BAND_ROWS - 1) / ANIMAL_BAND_ROWS; }
+
+    // Prioridade de um pedido de movimento: sorteio da iteração desempatado
+    // pela célula, então duas células nunca têm a mesma
+    uint64_t movePriority(const animal_keys_t &keys, uint32_t cell)
+    {
+        return (uint64_t)cellRandom(keys.move_priority, cell) << 32 | cell;
+    }
+
+    // Movimento, etapa 1: cada animal da linha decide, sobre o estado do
+    // início da iteração, se morre, se fica ou para qual vizinho permitido
+    // quer ir, e anota o pedido na própria célula. Nenhuma outra célula é
+    // alterada, então as linhas podem rodar em qualquer ordem.
+    template <typename Species, typename N, typename B>
+    void proposeRow(world_t &world, population_stats_t &delta, const animal_keys_t &keys, uint32_t i)
+    {
+        grid_t &grid = world.grid;
+        const species_rules_t rules = world.rules.animals[Species::type];
+        grid.occupancy[Species::type].forEachInRow(i, [&](uint32_t, uint32_t j) {
+            const uint32_t cell = (uint32_t)grid.index(i, j);
+            uint8_t &proposal = world.move_proposals[cell];
+
+            // Verificar se o animal atingiu a idade máxima ou ficou sem energia
+            if (grid.age[cell] >= rules.maximum_age || grid.energy[cell] <= 0)
+            {
+                proposal = MOVE_DIE;
+                return;
+            }
+            proposal = MOVE_STAY;
+            if (!drawProbability(cellRandom(keys.move, cell), rules.move_threshold))
+                return;
+
+            uint32_t options = grid.template neighbours<N>(i, j, Species::passable);
+            if (options)
+            {
+                proposal = (uint8_t)randomDirection(options, cellRandom(keys.move_direction, cell));
+            }
+            else
+            {
+                // Custo de energia para movimento sem sucesso
+                delta.remove(Species::type, grid.energy[cell], grid.age[cell]);
+                grid.energy[cell] -= rules.move_energy_cost;
+                delta.add(Species::type, grid.energy[cell], grid.age[cell]);
+            }
+        });
+    }
+
+    // Verdadeiro se o animal em (i, j) pediu para ir a `target`
+    template <typename N, typename B>
+    bool requestsTarget(const world_t &world, uint32_t i, uint32_t j, pos_t target)
+    {
+        const grid_t &grid = world.grid;
+        const uint8_t d = world.move_proposals[grid.index(i, j)];
+        if (d >= N::count)
+            return false;
+        const pos_t p = grid.template neighbourPos<N, B>(i, j, d);
+        return p.i == target.i && p.j == target.j;
+    }
+
+    // Vizinhança onde estão os animais que podem pedir uma célula como
+    // destino. Em geral é a própria, porque a relação de vizinhança é
+    // simétrica também nos contornos (validateTopology() recusa as grades em
+    // que não é). A exceção, proposital, é a hexagonal com reflect: o espelho
+    // de (i, -1) é (i, 1), mas (i, 0) nem sempre é vizinha hexagonal de
+    // (i ± 1, 1), então são olhadas todas as 8 células em volta, que contêm
+    // esses pares.
+    template <typename N, typename B>
+    using requesters_t =
+        std::conditional_t<std::is_same_v<N, hex_t> && std::is_same_v<B, reflect_t>, moore_t, N>;
+
+    // Movimento, etapa 2: cada animal com pedido verifica se tem a maior
+    // prioridade entre os que pediram o mesmo destino. O vencedor é anotado
+    // na lista da sua faixa com o estado do início da iteração; os outros
+    // ficam e pagam o custo do movimento sem sucesso. Só a energia do próprio
+    // animal é alterada e ninguém a lê nesta etapa.
+    template <typename Species, typename N, typename B>
+    void resolveRow(world_t &world, population_stats_t &delta, arena_t &arena, const animal_keys_t &keys,
+                    uint32_t band, uint32_t i)
+    {
+        grid_t &grid = world.grid;
+        const species_rules_t rules = world.rules.animals[Species::type];
+        const uint32_t next_band = (band + 1) % bandCount(grid);
+        grid.occupancy[Species::type].forEachInRow(i, [&](uint32_t, uint32_t j) {
+            const uint32_t cell = (uint32_t)grid.index(i, j);
+            const uint8_t d = world.move_proposals[cell];
+            if (d >= N::count)
+                return;
+
+            const pos_t target = grid.template neighbourPos<N, B>(i, j, d);
+            // Outros animais em volta do destino (as bordas dos mapas de
+            // ocupação já seguem o contorno)
+            using R = requesters_t<N, B>;
+            uint32_t rivals = grid.template neighbours<R>(target.i, target.j, ANIMAL_SET);
+            bool wins = true;
+            while (rivals && wins)
+            {
+                const uint32_t r = (uint32_t)__builtin_ctz(rivals);
+                rivals &= rivals - 1;
+                const pos_t c = grid.template neighbourPos<R, B>(target.i, target.j, r);
+                if ((c.i != i || c.j != j) && requestsTarget<N, B>(world, c.i, c.j, target) &&
+                    movePriority(keys, (uint32_t)grid.index(c.i, c.j)) > movePriority(keys, cell))
+                    wins = false;
+            }
+
+            if (wins)
+            {
+                const uint32_t target_band = target.i / ANIMAL_BAND_ROWS;
+                const move_list_t list = target_band == band        ? MOVES_SAME
+                                         : target_band == next_band ? MOVES_DOWN
+                                                                    : MOVES_UP;
+                world.moves[band * MOVE_LIST_COUNT + list].push_back(
+                    arena, {cell, (uint32_t)grid.index(target.i, target.j), Species::type, grid.energy[cell], grid.age[cell]});
+            }
+            else
+            {
+                delta.remove(Species::type, grid.energy[cell], grid.age[cell]);
+                grid.energy[cell] -= rules.move_energy_cost;
+                delta.add(Species::type, grid.energy[cell], grid.age[cell]);
+            }
+        });
+    }
+
+    // Movimento, etapa 3: esvazia as células dos animais que morreram e dos
+    // que vão se mover. Todas ficam na própria faixa.
+    template <typename... Species>
+    void departBand(world_t &world, population_stats_t &delta, uint32_t band, species_list_t<Species...>)
+    {
+        grid_t &grid = world.grid;
+        const uint32_t first = band * ANIMAL_BAND_ROWS;
+        const uint32_t last = std::min(first + ANIMAL_BAND_ROWS, grid.rows);
+        for (uint32_t i = first; i < last; i++)
+        {
+            auto departDead = [&](const bitboard_t &occupancy, entity_type_t type) {
+                occupancy.forEachInRow(i, [&](uint32_t, uint32_t j) {
+                    const size_t cell = grid.index(i, j);
+                    if (world.move_proposals[cell] != MOVE_DIE)
+                        return;
+                    delta.remove(type, grid.energy[cell], grid.age[cell]);
+                    grid.at(i, j) = {empty, 0, 0};
+                });
+            };
+            (departDead(grid.occupancy[Species::type], Species::type), ...);
+        }
+        for (uint32_t list = 0; list < MOVE_LIST_COUNT; list++)
+            world.moves[band * MOVE_LIST_COUNT + list].forEach([&](const animal_move_t &move) {
+                grid.at(move.source / grid.cols, move.source % grid.cols) = {empty, 0, 0};
+            });
+    }
+
+    // Movimento, etapa 4: coloca os animais nos destinos da faixa. O animal
+    // come a presa que ainda estiver no destino (uma presa que também se
+    // moveu já saiu na etapa 3).
+    void arriveBand(world_t &world, population_stats_t &delta, uint32_t band)
+    {
+        grid_t &grid = world.grid;
+        const uint32_t bands = bandCount(grid);
+        const arena_list_t<animal_move_t> *lists[] = {
+            &world.moves[((band + bands - 1) % bands) * MOVE_LIST_COUNT + MOVES_DOWN],
+            &world.moves[band * MOVE_LIST_COUNT + MOVES_SAME],
+            &world.moves[((band + 1) % bands) * MOVE_LIST_COUNT + MOVES_UP]};
+        for (const arena_list_t<animal_move_t> *list : lists)
+            list->forEach([&](const animal_move_t &move) {
+                const species_rules_t &rules = world.rules.animals[move.type];
+                const uint32_t i = move.target / grid.cols;
+                const uint32_t j = move.target % grid.cols;
+                const entity_type_t found = (entity_type_t)grid.type[move.target];
+                int32_t energy = move.energy;
+                if (speciesSet(found) & preyOf(move.type, animal_species_t{}))
+                {
+                    energy = std::min(energy + rules.eat_energy_gain, rules.maximum_energy);
+                    if (speciesSet(found) & ANIMAL_SET)
+                        delta.remove(found, grid.energy[move.target], grid.age[move.target]);
+                }
+                grid.at(i, j) = {move.type, energy - rules.move_energy_cost, move.age};
+                delta.remove(move.type, move.energy, move.age);
+                delta.add(move.type, energy - rules.move_energy_cost, move.age);
+            });
+    }
+
+    // Movimento dos animais em quatro etapas separadas por barreiras. Em
+    // cada etapa uma faixa só escreve nas próprias células, então todas as
+    // faixas rodam em paralelo, e o resultado não depende da ordem: conflitos
+    // pelo mesmo destino são decididos pela prioridade sorteada.
+    template <typename N, typename B>
+    void moveAnimals(world_t &world, worker_pool_t &pool, const animal_keys_t &keys)
+    {
+        const uint32_t bands = bandCount(world.grid);
+        world.moves.resize((size_t)bands * MOVE_LIST_COUNT);
+        for (arena_list_t<animal_move_t> &list : world.moves)
+            list.clear();
+
+        auto forEachBandRow = [&](uint32_t band, auto &&fn) {
+            const uint32_t first = band * ANIMAL_BAND_ROWS;
+            const uint32_t last = std::min(first + ANIMAL_BAND_ROWS, world.grid.rows);
+            for (uint32_t i = first; i < last; i++)
+                fn(i);
+        };
+        {
+            trace_scope_t trace("propose", "phase");
+            pool.parallelForWorkers(bands, [&](size_t band, unsigned worker) {
+                forEachBandRow((uint32_t)band, [&](uint32_t i) {
+                    proposeRow<herbivore_traits_t, N, B>(world, world.stats.partials[worker], keys, i);
+                    proposeRow<carnivore_traits_t, N, B>(world, world.stats.partials[worker], keys, i);
+                });
+            });
+        }
+        {
+            trace_scope_t trace("resolve", "phase");
+            pool.parallelForWorkers(bands, [&](size_t band, unsigned worker) {
+                forEachBandRow((uint32_t)band, [&](uint32_t i) {
+                    resolveRow<herbivore_traits_t, N, B>(world, world.stats.partials[worker], world.arenas[worker], keys,
+                                                         (uint32_t)band, i);
+                    resolveRow<carnivore_traits_t, N, B>(world, world.stats.partials[worker], world.arenas[worker], keys,
+                                                         (uint32_t)band, i);
+                });
+            });
+        }
+        {
+            trace_scope_t trace("depart", "phase");
+            pool.parallelForWorkers(bands, [&](size_t band, unsigned worker) {
+                departBand(world, world.stats.partials[worker], (uint32_t)band, animal_species_t{});
+            });
+        }
+        {
+            trace_scope_t trace("arrive", "phase");
+            pool.parallelForWorkers(bands, [&](size_t band, unsigned worker) {
+                arriveBand(world, world.stats.partials[worker], (uint32_t)band);
+            });
+        }
+    }
+
+    // Kernel genérico de um animal depois do movimento: alimentação,
+    // reprodução e envelhecimento. Os sorteios usam a célula onde o animal
+    // está. Cada mudança em animais é anotada em `delta`, a variação das
+    // estatísticas da thread. N e B são a vizinhança e o contorno da grade.
+    template <typename Species, typename N, typename B>
+    void updateAnimal(world_t &world, population_stats_t &delta, const species_rules_t &rules,
+                      const animal_keys_t &keys, uint32_t i, uint32_t j)
+    {
+        constexpr bool hunts_animals = (Species::prey & ANIMAL_SET) != 0;
+        grid_t &grid = world.grid;
+        const uint32_t cell = (uint32_t)grid.index(i, j);
+        const size_t idx = cell;
+        const int32_t start_energy = grid.energy[idx];
+        const int32_t start_age = grid.age[idx];
+
+        // Alimentação: come uma presa adjacente sorteada
+        if (drawProbability(cellRandom(keys.eat, cell), rules.eat_threshold))
+        {
+            uint32_t prey = grid.template neighbours<N>(i, j, Species::prey);
+            if (prey)
+            {
+                pos_t p = grid.template neighbourPos<N, B>(i, j, randomDirection(prey, cellRandom(keys.eat_direction, cell)));
+                if constexpr (hunts_animals)
+                {
+                    size_t prey_idx = grid.index(p.i, p.j);
+                    delta.remove((entity_type_t)grid.type[prey_idx], grid.energy[prey_idx], grid.age[prey_idx]);
+                }
+                grid.at(p.i, p.j) = {empty, 0, 0};
+                grid.energy[idx] = std::min(grid.energy[idx] + rules.eat_energy_gain, rules.maximum_energy);
+            }
+        }
+
+        // Reprodução: a prole vai para uma célula adjacente vazia sorteada
+        if (grid.energy[idx] > rules.reproduction_energy_threshold &&
+            drawProbability(cellRandom(keys.reproduction, cell), rules.reproduction_threshold))
+        {
+            uint32_t slots = grid.template neighbours<N>(i, j, speciesSet(empty));
+            if (slots)
+            {
+                pos_t child = grid.template neighbourPos<N, B>(i, j, randomDirection(slots, cellRandom(keys.reproduction_direction, cell)));
+                grid.at(child.i, child.j) = {Species::type, grid.energy[idx] - rules.reproduction_energy_cost, 0};
+                grid.energy[idx] -= rules.reproduction_energy_cost;
+                delta.add(Species::type, grid.energy[idx], 0);
+                world.acted.set(child.i, child.j); // a prole só age na próxima iteração
+            }
+        }
+
+        grid.age[idx]++;
+        delta.remove(Species::type, start_energy, start_age);
+        delta.add(Species::type, grid.energy[idx], grid.age[idx]);
+    }
+
+    // Atualiza os animais de uma espécie em uma linha. Os candidatos vêm
+    // palavra por palavra do mapa de ocupação, excluindo a prole nascida
+    // nesta iteração
+    template <typename Species, typename N, typename B>
+    void simulateRow(world_t &world, population_stats_t &delta, const animal_keys_t &keys, uint32_t i)
+    {
+        const bitboard_t &occupancy = world.grid.occupancy[Species::type];
+        const species_rules_t rules = world.rules.animals[Species::type];
+        for (uint32_t w = 0; w < occupancy.words_per_row; w++)
+        {
+            uint64_t bits = occupancy.row(i)[w] & occupancy.interiorMask(w) & ~world.acted.row(i)[w];
+            while (bits)
+            {
+                uint32_t j = w * 64 + (uint32_t)__builtin_ctzll(bits) - 1;
+                bits &= bits - 1;
+                // o animal pode ter sido comido ou substituído nesta iteração
+                if (world.grid.type[world.grid.index(i, j)] == Species::type && !world.acted.test(i, j))
+                    updateAnimal<Species, N, B>(world, delta, rules, keys, i, j);
+            }
+        }
+    }
+
+    template <typename N, typename B, typename... Species>
+    void simulateBand(world_t &world, population_stats_t &delta, const animal_keys_t &keys, uint32_t band,
+                      species_list_t<Species...>)
+    {
+        uint32_t first = band * ANIMAL_BAND_ROWS;
+        uint32_t last = std::min(first + ANIMAL_BAND_ROWS, world.grid.rows);
+        for (uint32_t i = first; i < last; i++)
+            (simulateRow<Species, N, B>(world, delta, keys, i), ...);
+    }
+
+    // Na alimentação e reprodução um animal alcança 1 linha além da própria
+    // faixa. No toro, a primeira faixa e a que alcança a última linha tocam a
+    // borda oposta e não podem rodar junto com as outras da mesma paridade.
+    template <typename B>
+    bool wrapsAround(uint32_t band, uint32_t rows)
+    {
+        if constexpr (B::id != BOUNDARY_TORUS)
+            return false;
+        return band == 0 || band * ANIMAL_BAND_ROWS + ANIMAL_BAND_ROWS >= rows;
+    }
+
+    template <typename N, typename B>
+    void simulateAnimals(world_t &world, worker_pool_t &pool, const animal_keys_t &keys)
+    {
+        const uint32_t rows = world.grid.rows;
+        const uint32_t bands = bandCount(world.grid);
+
+        // Faixas que dão a volta: em série, em ordem crescente, antes das outras
+        for (uint32_t band = 0; band < bands; band++)
+            if (wrapsAround<B>(band, rows))
+            {
+                trace_scope_t band_trace("band", "tile", "band", (int64_t)band);
+                simulateBand<N, B>(world, world.stats.partials[0], keys, band, animal_species_t{});
+            }
+
+        // Demais faixas: primeiro as pares, depois as ímpares
+        for (uint32_t parity = 0; parity < 2; parity++)
+        {
+            pool.parallelForWorkers((bands + 1 - parity) / 2, [&](size_t task, unsigned worker) {
+                const uint32_t band = (uint32_t)(2 * task + parity);
+                if (wrapsAround<B>(band, rows))
+                    return;
+                trace_scope_t band_trace("band", "tile", "band", (int64_t)band);
+                simulateBand<N, B>(world, world.stats.partials[worker], keys, band, animal_species_t{});
+            });
+        }
+    }
+}
+
+void simulateTick(world_t &world, worker_pool_t &pool)
+{
+    engine_metrics_t *metrics = world.metrics;
+    phase_timer_t tick_timer(metrics ? &metrics->ticks : nullptr);
+    trace_scope_t tick_trace("tick", "tick", "tick", (int64_t)world.tick);
+
+    // Fase das plantas: processada linha a linha pelo kernel vetorizado
+    {
+        phase_timer_t timer(metrics ? &metrics->phases[PHASE_PLANTS] : nullptr);
+        trace_scope_t trace("plants", "phase");
+        simulatePlants(world.grid, world.plant_seeded, world.rules.plant, world.seed, world.tick);
+    }
+
+    animal_keys_t keys;
+    {
+        phase_timer_t timer(metrics ? &metrics->phases[PHASE_SCHEDULE] : nullptr);
+        trace_scope_t trace("schedule", "phase");
+        world.acted.clear();
+        if (world.move_proposals.size() != world.grid.size())
+            world.move_proposals.assign(world.grid.size(), 0);
+        keys = animalKeys(world.seed, world.tick);
+        if (!world.stats.valid)
+            world.stats.rebuild(world.grid);
+        world.stats.partials.assign(pool.size(), population_stats_t());
+        // rascunho da iteração anterior
+        world.arenas.resize(pool.size());
+        for (arena_t &arena : world.arenas)
+            arena.reset();
+    }
+
+    // Movimento e depois alimentação e reprodução dos animais, em faixas de
+    // linhas (ver moveAnimals() e simulateAnimals())
+    dispatchTopology(world.grid.topology, [&](auto neighbourhood, auto boundary) {
+        using N = decltype(neighbourhood);
+        using B = decltype(boundary);
+        {
+            phase_timer_t timer(metrics ? &metrics->phases[PHASE_MOVEMENT] : nullptr);
+            trace_scope_t trace("movement", "phase");
+            moveAnimals<N, B>(world, pool, keys);
+        }
+        phase_timer_t timer(metrics ? &metrics->phases[PHASE_ANIMALS] : nullptr);
+        trace_scope_t trace("animals", "phase");
+        simulateAnimals<N, B>(world, pool, keys);
+    });
+    for (const population_stats_t &delta : world.stats.partials)
+        world.stats.totals.merge(delta);
+
+    if (world.views.active())
+    {
+        phase_timer_t timer(metrics ? &metrics->phases[PHASE_VIEWS] : nullptr);
+        trace_scope_t trace("views", "phase");
+        world.views.update(world.grid);
+    }
+
+    world.tick++;
+    if (metrics)
+        metrics->recordTick(std::chrono::steady_clock::now());
+}
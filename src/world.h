@@ -0,0 +1,92 @@
+#pragma once
+
+#include "arena.h"
+#include "grid.h"
+#include "metrics.h"
+#include "mipmap.h"
+#include "params.h"
+#include "stats.h"
+#include "worker_pool.h"
+#include <cstdint>
+#include <vector>
+
+// Movimento de um animal que venceu a disputa pela célula de destino, com o
+// estado do animal no início da iteração
+struct animal_move_t
+{
+    uint32_t source;
+    uint32_t target;
+    entity_type_t type;
+    int32_t energy;
+    int32_t age;
+};
+
+// Estado completo de uma simulação. Não há variáveis globais no motor, então
+// vários mundos podem ser simulados ao mesmo tempo.
+struct world_t
+{
+    grid_t grid;
+    uint64_t seed = 0;
+    uint64_t tick = 0;
+
+    // Parâmetros das regras e a versão pré-calculada usada pelos kernels;
+    // setParams() só deve ser chamado entre iterações
+    rule_params_t params;
+    compiled_rules_t rules = compileRules(params);
+
+    // Rascunhos reutilizados entre iterações
+    std::vector<uint8_t> plant_seeded;
+    bitboard_t acted; // prole nascida na iteração atual, que só age na próxima
+    std::vector<uint8_t> move_proposals;                // pedido de movimento de cada célula com animal
+    std::vector<arena_list_t<animal_move_t>> moves;     // movimentos vencedores, ver simulateTick()
+    std::vector<arena_t> arenas; // rascunho de cada thread do pool, esvaziado no começo de cada iteração
+
+    // Contagens por bloco para /view; inativa até a primeira rebuild(), e
+    // então atualizada ao fim de cada iteração
+    view_mipmap_t views;
+
+    // Contagens, energia e idades dos animais, atualizadas a cada iteração
+    animal_stats_t stats;
+
+    // Destino opcional das durações de cada fase (nulo = sem medição)
+    engine_metrics_t *metrics = nullptr;
+
+    void reset(uint32_t rows, uint32_t cols, uint64_t new_seed, topology_t topology = {})
+    {
+        grid.assign(rows, cols, topology);
+        views.reset();
+        stats.valid = false;
+        resetState(new_seed);
+    }
+
+    // Reinicia semente, iteração e rascunhos para a grade atual; usado quando
+    // a grade é preenchida diretamente (ver grid_t::adopt())
+    void resetState(uint64_t new_seed)
+    {
+        acted.assign(grid.rows, grid.cols);
+        move_proposals.assign(grid.size(), 0);
+        plant_seeded.assign((size_t)(grid.rows + 2) * (grid.cols + 2), 0); // com borda, ver simulatePlants()
+        seed = new_seed;
+        tick = 0;
+    }
+
+    void setParams(const rule_params_t &new_params)
+    {
+        params = new_params;
+        rules = compileRules(params);
+    }
+};
+
+// Número de linhas de cada faixa da fase dos animais, a unidade de trabalho
+// do pool de threads. Na alimentação e reprodução um animal só lê e escreve
+// até 1 linha fora da sua faixa, então faixas de mesma paridade podem rodar
+// em paralelo sem travas (no toro, as faixas que dão a volta rodam antes, em
+// série). O valor é fixo para que o resultado não dependa do número de
+// threads.
+const uint32_t ANIMAL_BAND_ROWS = 4;
+
+// Avança a simulação em uma iteração: fase das plantas, movimento dos
+// animais em duas etapas (pedidos e resolução dos conflitos) e por fim
+// alimentação e reprodução dos animais, em faixas executadas pelo pool de
+// threads
+void simulateTick(world_t &world, worker_pool_t &pool);